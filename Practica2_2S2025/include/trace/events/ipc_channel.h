@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM ipc_channel
+
+#if !defined(_TRACE_IPC_CHANNEL_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_IPC_CHANNEL_H
+
+#include <linux/tracepoint.h>
+
+// Mensaje encolado en un canal. stamp es el instante (ktime_get_ns) que se
+// guarda en la casilla; handoff indica entrega directa a un receptor estacionado.
+TRACE_EVENT(ipc_channel_enqueue,
+
+    TP_PROTO(const char *name, u32 prio, u32 len, u64 stamp, bool handoff),
+
+    TP_ARGS(name, prio, len, stamp, handoff),
+
+    TP_STRUCT__entry(
+        __string(name, name)
+        __field(u32, prio)
+        __field(u32, len)
+        __field(u64, stamp)
+        __field(bool, handoff)
+    ),
+
+    TP_fast_assign(
+        __assign_str(name);
+        __entry->prio = prio;
+        __entry->len = len;
+        __entry->stamp = stamp;
+        __entry->handoff = handoff;
+    ),
+
+    TP_printk("channel=%s prio=%u len=%u stamp=%llu handoff=%d",
+              __get_str(name), __entry->prio, __entry->len,
+              __entry->stamp, __entry->handoff)
+);
+
+// Mensaje entregado a un receptor. residency es el tiempo que pasó en la cola.
+TRACE_EVENT(ipc_channel_dequeue,
+
+    TP_PROTO(const char *name, u32 prio, u32 len, u64 stamp, u64 residency),
+
+    TP_ARGS(name, prio, len, stamp, residency),
+
+    TP_STRUCT__entry(
+        __string(name, name)
+        __field(u32, prio)
+        __field(u32, len)
+        __field(u64, stamp)
+        __field(u64, residency)
+    ),
+
+    TP_fast_assign(
+        __assign_str(name);
+        __entry->prio = prio;
+        __entry->len = len;
+        __entry->stamp = stamp;
+        __entry->residency = residency;
+    ),
+
+    TP_printk("channel=%s prio=%u len=%u stamp=%llu residency_ns=%llu",
+              __get_str(name), __entry->prio, __entry->len,
+              __entry->stamp, __entry->residency)
+);
+
+#endif /* _TRACE_IPC_CHANNEL_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -1,123 +1,2154 @@
 #include <linux/kernel.h>
+#include <linux/init.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/syscalls.h>
-#include <linux/list.h>
-#include <linux/mutex.h>
+#include <linux/atomic.h>
+#include <linux/cache.h>
 #include <linux/wait.h>
 #include <linux/sched.h>
 #include <linux/errno.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/anon_inodes.h>
+#include <linux/hashtable.h>
+#include <linux/stringhash.h>
+#include <linux/kref.h>
+#include <linux/mutex.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/poll.h>
+#include <linux/ktime.h>
+#include <linux/time64.h>
+#include <linux/uio.h>
+#include <linux/bitops.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/sched/task.h>
+#include <linux/hrtimer.h>
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/refcount.h>
+#include <linux/overflow.h>
+#include <linux/capability.h>
+#include <linux/sched/user.h>
+#include <linux/sched/signal.h>
+#include <linux/cred.h>
+#include <asm/shmparam.h>
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/ipc_channel.h>
+
+#define MAX_MSG_SIZE 512                    // Tamaño de mensaje del canal global
+#define MAX_QUEUE_SIZE 16                   // Profundidad del canal global
+#define MAX_VEC_COUNT 1024                  // Máximo de mensajes por llamada vectorizada
+#define VEC_CHUNK 16                        // Descriptores copiados por bloque
+
+#define IPC_NAME_MAX 64                     // Longitud máxima del nombre de un canal
+#define IPC_MAX_DEPTH (1 << 20)             // Profundidad máxima de un canal con nombre
+#define IPC_MAX_MSG (64 * 1024)             // Tamaño máximo de mensaje de un canal con nombre
+#define IPC_MAX_BYTES (64UL << 20)          // Memoria máxima de las casillas de un canal
+#define IPC_MAX_BULK (64U << 20)            // Tamaño máximo de un mensaje grande (páginas fijadas)
+#define IPC_MAX_CHANNELS 1024               // Canales con nombre registrados a la vez
+#define IPC_PRIO_LEVELS 32                  // Niveles de prioridad (mayor = más urgente)
+#define IPC_CHANNEL_DEFAULT -1              // fd que selecciona el canal global
+#define IPC_CHANNEL_SHM 0x1                 // Canal en memoria compartida (mmap)
+#define IPC_CHANNEL_HANDOFF 0x2             // Entrega directa a receptores en espera
+#define IPC_CHANNEL_BROADCAST 0x4           // Cada mensaje llega a todos los suscriptores
+#define IPC_CHANNEL_LAG 0x8                 // Difusión: sobrescribir en lugar de bloquear
+#define IPC_CHANNEL_SUBSCRIBE 0x10          // Difusión: el fd recibe mensajes
+#define IPC_FD_FLAGS (O_CLOEXEC | O_NONBLOCK)
+#define IPC_OPEN_FLAGS (IPC_FD_FLAGS | IPC_CHANNEL_SUBSCRIBE)
+#define IPC_CREATE_FLAGS (IPC_OPEN_FLAGS | IPC_CHANNEL_SHM | IPC_CHANNEL_HANDOFF | \
+                          IPC_CHANNEL_BROADCAST | IPC_CHANNEL_LAG)
+#define IPC_REC_ALIGN 16                    // Alineación de los registros de la arena
+#define IPC_ARENA_AVG_MSG 256               // Bytes de arena por casilla al dimensionarla
+#define IPC_HIST_BUCKETS 40                 // Histograma log2 de residencia (hasta ~9 minutos)
+#define IPC_PARK_PAGES (IPC_MAX_MSG / PAGE_SIZE + 1) // Páginas de un buffer de hasta IPC_MAX_MSG
+
+#define IPC_SHM_MAGIC 0x49504353            // "IPCS"
+
+// Límite de espera de una operación (instante absoluto de CLOCK_MONOTONIC)
+#define IPC_NOWAIT 0                        // No esperar: -EAGAIN
+#define IPC_FOREVER KTIME_MAX               // Esperar sin límite
+
+// Operaciones de ipc_channel_futex
+#define IPC_FUTEX_WAIT_DATA 0               // Dormir mientras data_seq == val
+#define IPC_FUTEX_WAIT_SPACE 1              // Dormir mientras space_seq == val
+#define IPC_FUTEX_WAKE_DATA 2               // Despertar a los consumidores dormidos
+#define IPC_FUTEX_WAKE_SPACE 3              // Despertar a los productores dormidos
+
+// Descriptor de un mensaje para ipc_channel_sendv/ipc_channel_recvv
+struct ipc_msg_vec {
+    __u64 data_pointer;         // Dirección del buffer usuario
+    __u32 len;                  // Longitud del mensaje / tamaño del buffer
+    __u32 prio;                 // Prioridad del mensaje (0 a IPC_PRIO_LEVELS - 1)
+};
+
+// Cabecera de un canal en memoria compartida. Es visible para el espacio de
+// usuario, que ejecuta el mismo algoritmo del anillo directamente sobre ella.
+// Cada contador va en su propia línea de caché.
+struct ipc_shm_header {
+    __u32 magic;                // IPC_SHM_MAGIC
+    __u32 depth;                // Cantidad de casillas (potencia de 2)
+    __u32 max_msg;              // Tamaño máximo de mensaje
+    __u32 slot_size;            // Bytes por casilla
+    __u32 slots_offset;         // Desplazamiento de la primera casilla
+    __u32 closed;               // 1 cuando se cerró el canal
+    __u64 head __aligned(64);   // Siguiente posición a escribir
+    __u64 tail __aligned(64);   // Siguiente posición a leer
+    __u32 data_seq __aligned(64);   // Se incrementa en cada publicación
+    __u32 data_waiters;             // Consumidores durmiendo en el kernel
+    __u32 space_seq __aligned(64);  // Se incrementa en cada liberación
+    __u32 space_waiters;            // Productores durmiendo en el kernel
+};
+
+// Casilla del anillo compartido (misma semántica de secuencia que struct slot)
+struct ipc_shm_slot {
+    __u64 seq;
+    __u32 len;
+    __u32 reserved;
+    char dat[];
+};
+
+// Casilla del anillo. La secuencia indica de quién es el turno:
+// - seq == pos      -> libre, la puede tomar el productor de la posición pos
+// - seq == pos + 1  -> ocupada, la puede tomar el consumidor de la posición pos
+// La casilla solo describe el mensaje; los datos están en la arena del anillo.
+struct slot {
+    atomic_long_t seq;
+    u32 len;                    // Longitud del mensaje
+    struct ipc_bulk *bulk;      // Mensaje grande en páginas del emisor, o NULL
+    long rec;                   // Posición del registro en la arena
+    u64 stamp;                  // Instante de encolado (ktime_get_ns)
+};
+
+// Registro de la arena: cabecera con la longitud total y los datos, alineado a
+// IPC_REC_ALIGN. Los registros ocupan solo lo que mide el mensaje.
+struct ipc_rec {
+    u32 size;                   // Bytes del registro, con cabecera y relleno
+    u32 freed;                  // El receptor ya copió los datos
+    char dat[];
+};
+
+// Estados de un mensaje grande
+enum {
+    BULK_PENDING,               // En cola, esperando receptor
+    BULK_COPYING,               // Un receptor lo está copiando
+    BULK_DONE,                  // Copiado; el emisor libera el descriptor
+    BULK_FAILED,                // La copia al receptor falló; el emisor libera el descriptor
+    BULK_CANCELLED,             // El emisor se rindió; el receptor libera el descriptor
+};
+
+// Mensaje mayor que max_msg. En lugar de copiarlo al heap del kernel se fijan
+// las páginas del emisor con pin_user_pages y el receptor copia una sola vez
+// desde ellas a su buffer. El emisor espera hasta que se complete la copia.
+struct ipc_bulk {
+    struct page **pages;
+    unsigned int nr_pages;
+    u32 offset;                 // Desplazamiento dentro de la primera página
+    u32 len;
+    atomic_t state;
+    struct user_struct *user;   // Usuario al que se cargaron las páginas, o NULL
+};
+
+// Estado de un receptor estacionado en un canal IPC_CHANNEL_HANDOFF
+enum {
+    PARK_WAITING,               // En la lista, esperando mensaje
+    PARK_CLAIMED,               // Un emisor lo sacó de la lista y está copiando
+    PARK_DONE,                  // Copia terminada; ret tiene el resultado
+};
+
+// Receptor bloqueado en un canal IPC_CHANNEL_HANDOFF. Vive en la pila del
+// receptor: fija las páginas de su buffer para que el emisor copie ahí
+// directamente, sin pasar por una casilla del anillo.
+struct ipc_parked {
+    struct list_head node;
+    struct task_struct *task;
+    struct page *pages[IPC_PARK_PAGES];
+    unsigned int nr_pages;
+    u32 offset;                 // Desplazamiento dentro de la primera página
+    u32 len;
+    u32 prio;                   // Prioridad del mensaje entregado
+    int ret;                    // Bytes entregados (0 si el emisor falló)
+    atomic_t state;
+    struct user_struct *user;   // Usuario al que se cargaron las páginas, o NULL
+};
+
+// Mensaje de un canal IPC_CHANNEL_BROADCAST. Se copia una sola vez desde el
+// emisor y lo comparten todos los suscriptores; el anillo tiene una referencia
+// y cada receptor toma otra mientras copia.
+struct ipc_bcast_msg {
+    refcount_t ref;
+    u32 len;
+    u32 prio;
+    u64 stamp;
+    char dat[];
+};
+
+// Suscriptor de un canal de difusión: cada fd abierto sobre el canal lee
+// con su propio cursor, empezando por los mensajes enviados después de abrirlo
+struct ipc_sub {
+    struct ipc_channel *ch;
+    struct list_head node;                              // En ch->subs si subscribed
+    u64 cursor;                                         // Siguiente mensaje a leer
+    bool subscribed;                                    // Abierto con IPC_CHANNEL_SUBSCRIBE
+};
+
+// Contadores de un canal. Son por CPU para que medir no agregue una línea de
+// caché compartida entre emisores y receptores; se suman al leerlos.
+struct ipc_channel_stats {
+    u64 msgs_sent;
+    u64 bytes_sent;
+    u64 msgs_recv;
+    u64 bytes_recv;
+    u64 send_wait_ns;           // Tiempo de emisores bloqueados esperando espacio
+    u64 recv_wait_ns;           // Tiempo de receptores bloqueados esperando mensajes
+    u64 residency[IPC_HIST_BUCKETS];  // Cubeta k: residencia en [2^(k-1), 2^k) ns
+};
+
+// Anillo acotado multi-productor/multi-consumidor preasignado.
+// head y tail van en líneas de caché distintas para no compartirlas
+// entre productores y consumidores.
+//
+// Los datos van en una arena circular de bytes aparte: el emisor reserva con
+// cmpxchg sobre arena_head solo los bytes del mensaje. Los receptores liberan
+// en cualquier orden y arena_tail avanza sobre los registros ya liberados.
+// arena_map marca dónde empieza cada registro escrito, para no interpretar
+// como cabecera los datos viejos de una vuelta anterior.
+struct ipc_ring {
+    atomic_long_t head ____cacheline_aligned_in_smp;   // Siguiente posición a escribir
+    atomic_long_t tail ____cacheline_aligned_in_smp;   // Siguiente posición a leer
+    atomic_long_t arena_head ____cacheline_aligned_in_smp;
+    atomic_long_t arena_tail ____cacheline_aligned_in_smp;
+    unsigned long arena_busy;                           // Bit 0: alguien avanza arena_tail
+
+    struct slot *slots ____cacheline_aligned_in_smp;
+    u32 depth;                                          // Potencia de 2
+    char *arena;
+    u32 arena_size;                                     // Potencia de 2
+    unsigned long *arena_map;                           // Un bit por IPC_REC_ALIGN bytes
+};
+
+// Canal de mensajes. Cada canal tiene un anillo por nivel de prioridad y sus
+// propias wait queues, así que canales distintos no compiten entre sí.
+// Los anillos de los niveles mayores que 0 se crean la primera vez que se usan.
+// ready tiene un bit por nivel que puede tener mensajes; el receptor toma el
+// nivel más alto con __fls en O(1).
+struct ipc_channel {
+    struct ipc_ring *rings[IPC_PRIO_LEVELS];
+    unsigned long ready ____cacheline_aligned_in_smp;
+    struct mutex lock;                                  // Creación de anillos de prioridad
+
+    u32 depth;                                          // Profundidad por defecto de cada nivel
+    u32 max_msg;
+    bool closed;
+    bool handoff;                                       // IPC_CHANNEL_HANDOFF
+
+    spinlock_t park_lock;
+    struct list_head parked;                            // Receptores estacionados, en orden FIFO
+
+    // Solo en canales IPC_CHANNEL_BROADCAST
+    bool bcast;
+    bool bcast_lag;                                     // IPC_CHANNEL_LAG
+    spinlock_t bcast_lock;                              // bmsgs, bhead, subs y cursores
+    struct ipc_bcast_msg **bmsgs;                       // Últimos depth mensajes
+    u64 bhead;                                          // Número del siguiente mensaje
+    struct list_head subs;
+
+    struct ipc_shm_header *shm;                         // Solo en canales IPC_CHANNEL_SHM
+    size_t shm_size;
+
+    wait_queue_head_t post_wq;                          // Procesos esperando enviar
+    wait_queue_head_t get_wq;                           // Procesos esperando recibir
+
+    struct ipc_channel_stats __percpu *stats;
+    struct dentry *debugfs;                             // Archivo en debugfs/ipc_channel
+
+    struct kref ref;                                    // Registro + un fd abierto por referencia
+    struct hlist_node node;                             // Nodo en channel_table
+    kuid_t owner;                                       // euid de quien lo creó; solo él lo cierra
+    char name[IPC_NAME_MAX];
+};
+
+// Registro de canales con nombre. El registro mantiene una referencia
+// a cada canal hasta que se cierra con ipc_channel_close. Hay a lo más
+// IPC_MAX_CHANNELS registrados (nr_channels, con channel_table_lock).
+static DEFINE_HASHTABLE(channel_table, 6);
+static DEFINE_MUTEX(channel_table_lock);
+static unsigned int nr_channels;
+
+// Canal global usado por ipc_channel_send/ipc_channel_receive
+static struct ipc_channel *default_channel;
+
+// Directorio /sys/kernel/debug/ipc_channel con las estadísticas de cada canal
+static struct dentry *ipc_debugfs_dir;
+
+// Descriptores de mensajes grandes
+static struct kmem_cache *bulk_cache;
+
+static const struct file_operations ipc_channel_fops;
+
+static inline struct slot *ring_slot(struct ipc_ring *r, long pos)
+{
+    return &r->slots[pos & (r->depth - 1)];
+}
+
+// Reserva una casilla libre para escribir. Retorna NULL si el anillo está lleno.
+static struct slot *ring_claim_post(struct ipc_ring *r, long *ppos)
+{
+    long pos = atomic_long_read(&r->head);
+    struct slot *s;
+    long dif;
+
+    for (;;) {
+        s = ring_slot(r, pos);
+        dif = atomic_long_read_acquire(&s->seq) - pos;
+        if (dif == 0) {
+            if (atomic_long_try_cmpxchg_relaxed(&r->head, &pos, pos + 1))
+                break;
+        } else if (dif < 0) {
+            return NULL;
+        } else {
+            pos = atomic_long_read(&r->head);
+        }
+    }
+
+    *ppos = pos;
+    return s;
+}
+
+// Reserva la siguiente casilla ocupada para leer. Retorna NULL si el anillo está vacío.
+static struct slot *ring_claim_get(struct ipc_ring *r, long *ppos)
+{
+    long pos = atomic_long_read(&r->tail);
+    struct slot *s;
+    long dif;
+
+    for (;;) {
+        s = ring_slot(r, pos);
+        dif = atomic_long_read_acquire(&s->seq) - (pos + 1);
+        if (dif == 0) {
+            if (atomic_long_try_cmpxchg_relaxed(&r->tail, &pos, pos + 1))
+                break;
+        } else if (dif < 0) {
+            return NULL;
+        } else {
+            pos = atomic_long_read(&r->tail);
+        }
+    }
+
+    *ppos = pos;
+    return s;
+}
+
+// Publica una casilla escrita para los consumidores
+static inline void ring_publish(struct slot *s, long pos)
+{
+    atomic_long_set_release(&s->seq, pos + 1);
+}
+
+// Devuelve una casilla leída a los productores (siguiente vuelta del anillo)
+static inline void ring_release(struct ipc_ring *r, struct slot *s, long pos)
+{
+    atomic_long_set_release(&s->seq, pos + r->depth);
+}
+
+static bool ring_full(struct ipc_ring *r)
+{
+    long pos = atomic_long_read(&r->head);
+
+    return atomic_long_read_acquire(&ring_slot(r, pos)->seq) - pos < 0;
+}
+
+static bool ring_empty(struct ipc_ring *r)
+{
+    long pos = atomic_long_read(&r->tail);
+
+    return atomic_long_read_acquire(&ring_slot(r, pos)->seq) - (pos + 1) < 0;
+}
+
+// Bytes que ocupa en la arena un registro de len bytes con su cabecera
+static inline u32 rec_size(u32 len)
+{
+    return ALIGN(sizeof(struct ipc_rec) + len, IPC_REC_ALIGN);
+}
+
+// Tamaño de la arena: IPC_ARENA_AVG_MSG bytes por casilla (o max_msg si es
+// menor), y al menos dos mensajes de max_msg para que siempre quepa uno
+static inline size_t arena_size_for(u32 depth, u32 max_msg)
+{
+    size_t size = (size_t)roundup_pow_of_two(depth) * rec_size(min_t(u32, max_msg, IPC_ARENA_AVG_MSG));
+
+    return roundup_pow_of_two(max_t(size_t, size, 2 * rec_size(max_msg)));
+}
+
+static inline struct ipc_rec *arena_rec(struct ipc_ring *r, long pos)
+{
+    return (struct ipc_rec *)(r->arena + (pos & (r->arena_size - 1)));
+}
+
+static inline unsigned long arena_bit(struct ipc_ring *r, long pos)
+{
+    return (pos & (r->arena_size - 1)) / IPC_REC_ALIGN;
+}
+
+// Relleno necesario para que un registro de need bytes no cruce el final de la arena
+static inline u32 arena_pad(struct ipc_ring *r, long head, u32 need)
+{
+    u32 off = head & (r->arena_size - 1);
+
+    return off + need > r->arena_size ? r->arena_size - off : 0;
+}
+
+static bool arena_fits(struct ipc_ring *r, u32 len)
+{
+    long head = atomic_long_read(&r->arena_head);
+    u32 need = rec_size(len);
+
+    return head + arena_pad(r, head, need) + need - atomic_long_read_acquire(&r->arena_tail) <=
+           r->arena_size;
+}
+
+// Escribe la cabecera de un registro y lo marca en arena_map
+static inline void arena_init_rec(struct ipc_ring *r, long pos, u32 size, u32 freed)
+{
+    struct ipc_rec *rec = arena_rec(r, pos);
+
+    rec->size = size;
+    rec->freed = freed;
+    smp_mb__before_atomic();
+    set_bit(arena_bit(r, pos), r->arena_map);
+}
+
+// Reserva un registro para len bytes. Retorna su posición o -1 si no hay espacio.
+static long arena_reserve(struct ipc_ring *r, u32 len)
+{
+    long head = atomic_long_read(&r->arena_head);
+    u32 need = rec_size(len);
+    u32 pad;
+
+    do {
+        pad = arena_pad(r, head, need);
+        if (head + pad + need - atomic_long_read_acquire(&r->arena_tail) > r->arena_size)
+            return -1;
+    } while (!atomic_long_try_cmpxchg_relaxed(&r->arena_head, &head, head + pad + need));
+
+    // El relleno hasta el final de la arena queda liberado desde el principio
+    if (pad)
+        arena_init_rec(r, head, pad, 1);
+    arena_init_rec(r, head + pad, need, 0);
+    return head + pad;
+}
+
+// ¿El registro en arena_tail ya fue escrito y liberado?
+static bool arena_tail_freed(struct ipc_ring *r, long tail)
+{
+    if (tail == atomic_long_read(&r->arena_head))
+        return false;
+    if (!test_bit(arena_bit(r, tail), r->arena_map))
+        return false;
+    smp_rmb();
+    return smp_load_acquire(&arena_rec(r, tail)->freed);
+}
+
+// Avanza arena_tail sobre los registros liberados. Lo hace un solo proceso a
+// la vez; si otro ya está avanzando, él revisa de nuevo al terminar.
+static void arena_advance(struct ipc_ring *r)
+{
+    long tail;
+
+    do {
+        if (test_and_set_bit_lock(0, &r->arena_busy))
+            return;
+
+        tail = atomic_long_read(&r->arena_tail);
+        while (arena_tail_freed(r, tail)) {
+            clear_bit(arena_bit(r, tail), r->arena_map);
+            tail += arena_rec(r, tail)->size;
+        }
+        atomic_long_set_release(&r->arena_tail, tail);
+
+        clear_bit_unlock(0, &r->arena_busy);
+        smp_mb__after_atomic();
+    } while (arena_tail_freed(r, atomic_long_read(&r->arena_tail)));
+}
+
+static void arena_free(struct ipc_ring *r, struct ipc_rec *rec)
+{
+    smp_store_release(&rec->freed, 1);     // Después de copiar los datos
+    smp_mb();       // Par con la revisión de arena_advance tras soltar arena_busy
+    arena_advance(r);
+}
+
+// Solo se toca la wait queue si hay alguien durmiendo (wq_has_sleeper incluye la barrera)
+static inline void wake_if_sleeping(struct wait_queue_head *wq)
+{
+    if (wq_has_sleeper(wq))
+        wake_up_interruptible(wq);
+}
+
+// Duerme en wq hasta que se cumpla cond o llegue el límite absoluto deadline.
+// Retorna 0, -ERESTARTSYS si llegó una señal o -ETIMEDOUT si se venció el límite.
+// Como el límite es absoluto, reiniciar la syscall tras una señal es seguro.
+#define channel_wait_event(wq, cond, deadline)                                  \
+({                                                                              \
+    long __ret = 0;                                                             \
+    ktime_t __left;                                                             \
+                                                                                \
+    if ((deadline) == IPC_FOREVER) {                                            \
+        __ret = wait_event_interruptible(wq, cond);                             \
+    } else {                                                                    \
+        __left = ktime_sub(deadline, ktime_get());                              \
+        if (__left <= 0)                                                        \
+            __ret = -ETIMEDOUT;                                                 \
+        else                                                                    \
+            __ret = wait_event_interruptible_hrtimeout(wq, cond, __left);       \
+        if (__ret == -ETIME)                                                    \
+            __ret = -ETIMEDOUT;                                                 \
+    }                                                                           \
+    __ret;                                                                      \
+})
+
+// Reserva e inicializa las páginas compartidas de un canal IPC_CHANNEL_SHM
+static int channel_alloc_shm(struct ipc_channel *ch)
+{
+    struct ipc_shm_header *h;
+    struct ipc_shm_slot *s;
+    size_t slot_size = ALIGN(sizeof(struct ipc_shm_slot) + ch->max_msg, SMP_CACHE_BYTES);
+    size_t offset = ALIGN(sizeof(*h), SMP_CACHE_BYTES);
+    u32 i;
+
+    ch->shm_size = PAGE_ALIGN(offset + ch->depth * slot_size);
+    // Como vmalloc_user, pero cargado al memcg de quien crea el canal
+    h = __vmalloc_node_range(ch->shm_size, SHMLBA, VMALLOC_START, VMALLOC_END,
+                             GFP_KERNEL_ACCOUNT | __GFP_ZERO, PAGE_KERNEL, VM_USERMAP,
+                             NUMA_NO_NODE, __builtin_return_address(0));
+    if (!h)
+        return -ENOMEM;
+
+    h->magic = IPC_SHM_MAGIC;
+    h->depth = ch->depth;
+    h->max_msg = ch->max_msg;
+    h->slot_size = slot_size;
+    h->slots_offset = offset;
+    for (i = 0; i < ch->depth; i++) {
+        s = (void *)h + offset + i * slot_size;
+        s->seq = i;
+    }
+
+    ch->shm = h;
+    return 0;
+}
+
+// Verifica que las casillas y la arena de un anillo no excedan el límite de memoria
+static inline bool ring_size_ok(u32 depth, u32 max_msg)
+{
+    return (size_t)roundup_pow_of_two(depth) * sizeof(struct slot) +
+           arena_size_for(depth, max_msg) <= IPC_MAX_BYTES;
+}
+
+// Mismo límite para un canal IPC_CHANNEL_SHM, cuyas casillas son de tamaño fijo
+static inline bool shm_size_ok(u32 depth, u32 max_msg)
+{
+    return (size_t)roundup_pow_of_two(depth) *
+           ALIGN(sizeof(struct ipc_shm_slot) + max_msg, SMP_CACHE_BYTES) <= IPC_MAX_BYTES;
+}
+
+// Crea un anillo preasignado. La memoria de los canales la pide el espacio
+// de usuario y puede ser grande, así que se carga a su memcg (_ACCOUNT).
+static struct ipc_ring *ring_alloc(u32 depth, u32 max_msg)
+{
+    struct ipc_ring *r;
+    u32 i;
+
+    r = kzalloc(sizeof(*r), GFP_KERNEL_ACCOUNT);
+    if (!r)
+        return NULL;
+
+    r->depth = roundup_pow_of_two(depth);
+    r->arena_size = arena_size_for(depth, max_msg);
+    r->slots = kvcalloc(r->depth, sizeof(*r->slots), GFP_KERNEL_ACCOUNT);
+    r->arena = kvmalloc(r->arena_size, GFP_KERNEL_ACCOUNT);
+    r->arena_map = kvcalloc(BITS_TO_LONGS(r->arena_size / IPC_REC_ALIGN), sizeof(long),
+                            GFP_KERNEL_ACCOUNT);
+    if (!r->slots || !r->arena || !r->arena_map) {
+        kvfree(r->slots);
+        kvfree(r->arena);
+        kvfree(r->arena_map);
+        kfree(r);
+        return NULL;
+    }
+
+    for (i = 0; i < r->depth; i++)
+        atomic_long_set(&ring_slot(r, i)->seq, i);
+    return r;
+}
+
+static void bulk_free(struct ipc_bulk *b);
+
+static void ring_free(struct ipc_ring *r)
+{
+    u32 i;
+
+    if (!r)
+        return;
+
+    // Mensajes grandes que nadie recibió (sus emisores ya los cancelaron)
+    for (i = 0; i < r->depth; i++) {
+        if (ring_slot(r, i)->bulk)
+            bulk_free(ring_slot(r, i)->bulk);
+    }
+
+    kvfree(r->slots);
+    kvfree(r->arena);
+    kvfree(r->arena_map);
+    kfree(r);
+}
+
+// Crea un canal con el anillo del nivel 0 preasignado
+static struct ipc_channel *channel_alloc(const char *name, u32 depth, u32 max_msg, int flags)
+{
+    struct ipc_channel *ch;
+
+    ch = kzalloc(sizeof(*ch), GFP_KERNEL_ACCOUNT);
+    if (!ch)
+        return NULL;
+
+    ch->depth = roundup_pow_of_two(depth);
+    ch->max_msg = max_msg;
+
+    if (flags & IPC_CHANNEL_SHM) {
+        // Los datos viven en las páginas compartidas, no hay anillo en el kernel
+        if (channel_alloc_shm(ch)) {
+            kfree(ch);
+            return NULL;
+        }
+    } else if (flags & IPC_CHANNEL_BROADCAST) {
+        ch->bmsgs = kvcalloc(ch->depth, sizeof(*ch->bmsgs), GFP_KERNEL_ACCOUNT);
+        if (!ch->bmsgs) {
+            kfree(ch);
+            return NULL;
+        }
+    } else {
+        ch->rings[0] = ring_alloc(depth, max_msg);
+        if (!ch->rings[0]) {
+            kfree(ch);
+            return NULL;
+        }
+    }
+
+    ch->stats = alloc_percpu_gfp(struct ipc_channel_stats, GFP_KERNEL_ACCOUNT);
+    if (!ch->stats) {
+        ring_free(ch->rings[0]);
+        vfree(ch->shm);
+        kvfree(ch->bmsgs);
+        kfree(ch);
+        return NULL;
+    }
+
+    ch->handoff = flags & IPC_CHANNEL_HANDOFF;
+    ch->bcast = flags & IPC_CHANNEL_BROADCAST;
+    ch->bcast_lag = flags & IPC_CHANNEL_LAG;
+    spin_lock_init(&ch->bcast_lock);
+    INIT_LIST_HEAD(&ch->subs);
+    spin_lock_init(&ch->park_lock);
+    INIT_LIST_HEAD(&ch->parked);
+    mutex_init(&ch->lock);
+    init_waitqueue_head(&ch->post_wq);
+    init_waitqueue_head(&ch->get_wq);
+    kref_init(&ch->ref);
+    INIT_HLIST_NODE(&ch->node);
+    strscpy(ch->name, name, IPC_NAME_MAX);
+    return ch;
+}
+
+// Carga nr_pages páginas fijadas al locked_vm del usuario, contra su
+// RLIMIT_MEMLOCK, igual que io_uring con los buffers registrados. Sin esto un
+// proceso podría fijar memoria sin límite enviando desde muchos hilos.
+static int bulk_account(struct user_struct *user, unsigned long nr_pages)
+{
+    unsigned long limit = rlimit(RLIMIT_MEMLOCK) >> PAGE_SHIFT;
+    unsigned long cur, new;
+
+    cur = atomic_long_read(&user->locked_vm);
+    do {
+        new = cur + nr_pages;
+        if (new > limit)
+            return -ENOMEM;
+    } while (!atomic_long_try_cmpxchg(&user->locked_vm, &cur, new));
+    return 0;
+}
+
+static void bulk_unaccount(struct user_struct *user, unsigned long nr_pages)
+{
+    if (!user)
+        return;
+    atomic_long_sub(nr_pages, &user->locked_vm);
+    free_uid(user);
+}
+
+// Fija las páginas del buffer del emisor para un mensaje grande
+static struct ipc_bulk *bulk_alloc(const char __user *dat, u32 len)
+{
+    unsigned long addr = (unsigned long)dat;
+    struct ipc_bulk *b;
+    int pinned;
+
+    b = kmem_cache_alloc(bulk_cache, GFP_KERNEL);
+    if (!b)
+        return ERR_PTR(-ENOMEM);
+
+    b->offset = offset_in_page(addr);
+    b->len = len;
+    b->nr_pages = DIV_ROUND_UP(b->offset + len, PAGE_SIZE);
+    b->user = NULL;
+    if (!capable(CAP_IPC_LOCK)) {
+        if (bulk_account(current_user(), b->nr_pages)) {
+            kmem_cache_free(bulk_cache, b);
+            return ERR_PTR(-ENOMEM);
+        }
+        b->user = get_uid(current_user());
+    }
+
+    b->pages = kvmalloc_array(b->nr_pages, sizeof(*b->pages), GFP_KERNEL);
+    if (!b->pages) {
+        bulk_unaccount(b->user, b->nr_pages);
+        kmem_cache_free(bulk_cache, b);
+        return ERR_PTR(-ENOMEM);
+    }
+
+    // FOLL_LONGTERM porque el mensaje puede esperar receptor un tiempo indefinido
+    pinned = pin_user_pages_fast(addr & PAGE_MASK, b->nr_pages, FOLL_LONGTERM, b->pages);
+    if (pinned != b->nr_pages) {
+        if (pinned > 0)
+            unpin_user_pages(b->pages, pinned);
+        kvfree(b->pages);
+        bulk_unaccount(b->user, b->nr_pages);
+        kmem_cache_free(bulk_cache, b);
+        return ERR_PTR(pinned < 0 ? pinned : -EFAULT);
+    }
+
+    atomic_set(&b->state, BULK_PENDING);
+    return b;
+}
+
+static void bulk_free(struct ipc_bulk *b)
+{
+    unpin_user_pages(b->pages, b->nr_pages);
+    kvfree(b->pages);
+    bulk_unaccount(b->user, b->nr_pages);
+    kmem_cache_free(bulk_cache, b);
+}
+
+// Copia un mensaje grande desde las páginas del emisor al buffer del receptor
+// La copia terminó, bien o mal, y el descriptor vuelve al emisor
+static inline bool bulk_finished(struct ipc_bulk *b)
+{
+    int state = atomic_read_acquire(&b->state);
+
+    return state == BULK_DONE || state == BULK_FAILED;
+}
+
+static long bulk_copy_to_user(struct ipc_bulk *b, char __user *dat, u32 len)
+{
+    size_t left = min(len, b->len), off = b->offset, n;
+    struct iov_iter iter;
+    unsigned int i;
+
+    if (import_ubuf(ITER_DEST, dat, left, &iter))
+        return -EFAULT;
+
+    for (i = 0; left; i++) {
+        n = min_t(size_t, PAGE_SIZE - off, left);
+        if (copy_page_to_iter(b->pages[i], off, n, &iter) != n)
+            return -EFAULT;
+        left -= n;
+        off = 0;
+    }
+    return min(len, b->len);
+}
+
+static inline void bcast_msg_put(struct ipc_bcast_msg *m)
+{
+    if (m && refcount_dec_and_test(&m->ref))
+        kfree(m);
+}
+
+static void channel_free(struct kref *ref)
+{
+    struct ipc_channel *ch = container_of(ref, struct ipc_channel, ref);
+    u32 i;
+
+    debugfs_remove(ch->debugfs);
+    for (i = 0; i < IPC_PRIO_LEVELS; i++)
+        ring_free(ch->rings[i]);
+    for (i = 0; ch->bmsgs && i < ch->depth; i++)
+        bcast_msg_put(ch->bmsgs[i]);
+    kvfree(ch->bmsgs);
+    vfree(ch->shm);
+    free_percpu(ch->stats);
+    kfree(ch);
+}
+
+static inline void channel_put(struct ipc_channel *ch)
+{
+    kref_put(&ch->ref, channel_free);
+}
+
+// Busca un canal por nombre. Se llama con channel_table_lock tomado.
+static struct ipc_channel *channel_lookup(const char *name)
+{
+    struct ipc_channel *ch;
+
+    hash_for_each_possible(channel_table, ch, node, full_name_hash(NULL, name, strlen(name))) {
+        if (!strcmp(ch->name, name))
+            return ch;
+    }
+    return NULL;
+}
+
+// Copia el nombre de un canal desde el espacio de usuario
+static int channel_copy_name(char *name, const char __user *uname)
+{
+    long n = strncpy_from_user(name, uname, IPC_NAME_MAX);
+
+    if (n < 0)
+        return n;
+    if (n == 0)
+        return -EINVAL;
+    if (n == IPC_NAME_MAX)
+        return -ENAMETOOLONG;
+    return 0;
+}
+
+static const struct file_operations ipc_sub_fops;
+
+// Crea un fd para un canal de difusión. Con IPC_CHANNEL_SUBSCRIBE el fd es un
+// suscriptor que empieza a leer desde el siguiente mensaje que se envíe; sin él
+// solo publica y no retiene mensajes, así que un emisor nunca se bloquea
+// esperando a su propio cursor.
+static int channel_install_sub(struct ipc_channel *ch, int flags)
+{
+    struct ipc_sub *sub;
+    int fd;
+
+    sub = kmalloc(sizeof(*sub), GFP_KERNEL);
+    if (!sub) {
+        channel_put(ch);
+        return -ENOMEM;
+    }
+    sub->ch = ch;
+    sub->cursor = 0;
+    sub->subscribed = flags & IPC_CHANNEL_SUBSCRIBE;
+
+    if (sub->subscribed) {
+        spin_lock(&ch->bcast_lock);
+        sub->cursor = ch->bhead;
+        list_add(&sub->node, &ch->subs);
+        spin_unlock(&ch->bcast_lock);
+    }
+
+    fd = anon_inode_getfd("[ipc_channel]", &ipc_sub_fops, sub, O_RDWR | (flags & IPC_FD_FLAGS));
+    if (fd < 0) {
+        if (sub->subscribed) {
+            spin_lock(&ch->bcast_lock);
+            list_del(&sub->node);
+            spin_unlock(&ch->bcast_lock);
+        }
+        kfree(sub);
+        channel_put(ch);
+    }
+    return fd;
+}
+
+// Crea un fd anónimo que referencia al canal. Consume la referencia recibida.
+static int channel_install_fd(struct ipc_channel *ch, int flags)
+{
+    int fd;
+
+    if (ch->bcast)
+        return channel_install_sub(ch, flags);
+
+    fd = anon_inode_getfd("[ipc_channel]", &ipc_channel_fops, ch,
+                          O_RDWR | (flags & IPC_FD_FLAGS));
+    if (fd < 0)
+        channel_put(ch);
+    return fd;
+}
+
+static int ipc_channel_release(struct inode *inode, struct file *file)
+{
+    channel_put(file->private_data);
+    return 0;
+}
+
+// Mapea las páginas compartidas de un canal IPC_CHANNEL_SHM (cabecera + casillas)
+static int ipc_channel_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    struct ipc_channel *ch = file->private_data;
+
+    if (!ch->shm)
+        return -ENODEV;
+    if (vma->vm_pgoff || vma->vm_end - vma->vm_start > ch->shm_size)
+        return -EINVAL;
+    if (!(vma->vm_flags & VM_SHARED))
+        return -EINVAL;
+
+    return remap_vmalloc_range(vma, ch->shm, 0);
+}
+
+// Disponibilidad del canal para poll/epoll: legible si hay mensajes (o se cerró,
+// en cuyo caso recvv retorna 0) y escribible si algún nivel ya creado tiene
+// espacio, porque cada emisor elige su nivel. Los niveles que todavía no se
+// usaron no cuentan.
+// Los canales compartidos no pasan por el kernel y no se pueden sondear.
+static __poll_t ipc_channel_poll(struct file *file, struct poll_table_struct *wait)
+{
+    struct ipc_channel *ch = file->private_data;
+    struct ipc_ring *r;
+    __poll_t mask = 0;
+    u32 prio;
+
+    if (ch->shm)
+        return EPOLLERR;
+
+    poll_wait(file, &ch->get_wq, wait);
+    poll_wait(file, &ch->post_wq, wait);
+
+    if (READ_ONCE(ch->ready))
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if (READ_ONCE(ch->closed))
+        mask |= EPOLLIN | EPOLLRDNORM | EPOLLHUP;
+    else {
+        for (prio = 0; prio < IPC_PRIO_LEVELS; prio++) {
+            r = smp_load_acquire(&ch->rings[prio]);
+            if (r && !ring_full(r) && arena_fits(r, 1)) {
+                mask |= EPOLLOUT | EPOLLWRNORM;
+                break;
+            }
+        }
+    }
+    return mask;
+}
+
+static const struct file_operations ipc_channel_fops = {
+    .owner   = THIS_MODULE,
+    .release = ipc_channel_release,
+    .mmap    = ipc_channel_mmap,
+    .poll    = ipc_channel_poll,
+    .llseek  = noop_llseek,
+};
+
+// Cursor del suscriptor más atrasado. Sin suscriptores no hay nada que retener.
+// Se llama con bcast_lock tomado.
+static u64 bcast_min_cursor(struct ipc_channel *ch)
+{
+    struct ipc_sub *sub;
+    u64 min = ch->bhead;
+
+    list_for_each_entry(sub, &ch->subs, node)
+        min = min_t(u64, min, sub->cursor);
+    return min;
+}
+
+// Lleno si el suscriptor más lento todavía no leyó el mensaje que se sobrescribiría
+static bool bcast_full(struct ipc_channel *ch)
+{
+    bool full;
+
+    spin_lock(&ch->bcast_lock);
+    full = ch->bhead - bcast_min_cursor(ch) >= ch->depth;
+    spin_unlock(&ch->bcast_lock);
+    return full;
+}
+
+static int ipc_sub_release(struct inode *inode, struct file *file)
+{
+    struct ipc_sub *sub = file->private_data;
+    struct ipc_channel *ch = sub->ch;
+
+    if (sub->subscribed) {
+        spin_lock(&ch->bcast_lock);
+        list_del(&sub->node);
+        spin_unlock(&ch->bcast_lock);
+
+        // Si era el suscriptor más lento, los emisores pueden avanzar
+        wake_up_interruptible_all(&ch->post_wq);
+    }
+    kfree(sub);
+    channel_put(ch);
+    return 0;
+}
+
+static __poll_t ipc_sub_poll(struct file *file, struct poll_table_struct *wait)
+{
+    struct ipc_sub *sub = file->private_data;
+    struct ipc_channel *ch = sub->ch;
+    __poll_t mask = 0;
+
+    poll_wait(file, &ch->get_wq, wait);
+    poll_wait(file, &ch->post_wq, wait);
+
+    if (sub->subscribed && READ_ONCE(sub->cursor) != READ_ONCE(ch->bhead))
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if (READ_ONCE(ch->closed))
+        mask |= EPOLLIN | EPOLLRDNORM | EPOLLHUP;
+    else if (ch->bcast_lag || !bcast_full(ch))
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    return mask;
+}
+
+static const struct file_operations ipc_sub_fops = {
+    .owner   = THIS_MODULE,
+    .release = ipc_sub_release,
+    .poll    = ipc_sub_poll,
+    .llseek  = noop_llseek,
+};
+
+// Obtiene el canal asociado a un fd. IPC_CHANNEL_DEFAULT selecciona el canal global.
+static struct ipc_channel *channel_fdget(int fd, struct fd *f)
+{
+    if (fd == IPC_CHANNEL_DEFAULT) {
+        *f = EMPTY_FD;
+        return default_channel;
+    }
+
+    *f = fdget(fd);
+    if (!fd_file(*f))
+        return ERR_PTR(-EBADF);
+    if (fd_file(*f)->f_op == &ipc_sub_fops)
+        return ((struct ipc_sub *)fd_file(*f)->private_data)->ch;
+    if (fd_file(*f)->f_op != &ipc_channel_fops) {
+        fdput(*f);
+        return ERR_PTR(-EINVAL);
+    }
+    return fd_file(*f)->private_data;
+}
+
+// Suscriptor asociado a un fd de canal de difusión, o NULL
+static inline struct ipc_sub *channel_sub(struct fd f)
+{
+    if (fd_file(f) && fd_file(f)->f_op == &ipc_sub_fops)
+        return fd_file(f)->private_data;
+    return NULL;
+}
+
+// Nombre del canal para trazas y debugfs
+static inline const char *channel_label(struct ipc_channel *ch)
+{
+    return ch->name[0] ? ch->name : "default";
+}
+
+static int __init ipc_channel_init(void)
+{
+    bulk_cache = KMEM_CACHE(ipc_bulk, 0);
+    if (!bulk_cache)
+        return -ENOMEM;
+
+    default_channel = channel_alloc("", MAX_QUEUE_SIZE, MAX_MSG_SIZE, IPC_CHANNEL_HANDOFF);
+    return default_channel ? 0 : -ENOMEM;
+}
+core_initcall(ipc_channel_init);
 
-#define MAX_MSG_SIZE 512
-#define MAX_QUEUE_SIZE 10
+// Estadísticas de un canal: suma de los contadores por CPU, ocupación actual
+// de cada nivel de prioridad e histograma log2 del tiempo en cola
+static int channel_stats_show(struct seq_file *m, void *v)
+{
+    struct ipc_channel *ch = m->private;
+    struct ipc_channel_stats sum = {};
+    struct ipc_channel_stats *st;
+    struct ipc_ring *r;
+    int cpu, i;
 
-// Estructura del mensaje
-struct item {
-    char dat[MAX_MSG_SIZE];     // Datos del mensaje
-    u32 len;                    // Longitud del mensaje
-    struct list_head node;      // Nodo para lista enlazada
-};
+    for_each_possible_cpu(cpu) {
+        st = per_cpu_ptr(ch->stats, cpu);
+        sum.msgs_sent += st->msgs_sent;
+        sum.bytes_sent += st->bytes_sent;
+        sum.msgs_recv += st->msgs_recv;
+        sum.bytes_recv += st->bytes_recv;
+        sum.send_wait_ns += st->send_wait_ns;
+        sum.recv_wait_ns += st->recv_wait_ns;
+        for (i = 0; i < IPC_HIST_BUCKETS; i++)
+            sum.residency[i] += st->residency[i];
+    }
 
-// Cola de mensajes y sincronización
-static LIST_HEAD(data_queue);                       // Lista doblemente enlazada para mensajes
-static DEFINE_MUTEX(queue_mutex);                   // Mutex para acceso concurrente
-static DECLARE_WAIT_QUEUE_HEAD(post_wait_queue);    // Procesos esperando enviar
-static DECLARE_WAIT_QUEUE_HEAD(get_wait_queue);     // Procesos esperando recibir
+    seq_printf(m, "mensajes_enviados: %llu\n", sum.msgs_sent);
+    seq_printf(m, "bytes_enviados: %llu\n", sum.bytes_sent);
+    seq_printf(m, "mensajes_recibidos: %llu\n", sum.msgs_recv);
+    seq_printf(m, "bytes_recibidos: %llu\n", sum.bytes_recv);
+    seq_printf(m, "espera_emisores_ns: %llu\n", sum.send_wait_ns);
+    seq_printf(m, "espera_receptores_ns: %llu\n", sum.recv_wait_ns);
 
-static int current_queue_size = 0;             // Tamaño actual de la cola
+    seq_puts(m, "ocupacion:\n");
+    for (i = 0; i < IPC_PRIO_LEVELS; i++) {
+        r = smp_load_acquire(&ch->rings[i]);
+        if (r)
+            seq_printf(m, "  prio %2d: %ld/%u mensajes, %ld/%u bytes\n", i,
+                       atomic_long_read(&r->head) - atomic_long_read(&r->tail), r->depth,
+                       atomic_long_read(&r->arena_head) - atomic_long_read(&r->arena_tail),
+                       r->arena_size);
+    }
 
-// Syscall para enviar mensaje al canal
-SYSCALL_DEFINE2(ipc_channel_send, const char __user *, dat, u32, len)
+    seq_puts(m, "residencia_ns:\n");
+    for (i = 0; i < IPC_HIST_BUCKETS; i++) {
+        if (!sum.residency[i])
+            continue;
+        if (i == 0)
+            seq_printf(m, "  [0, 1): %llu\n", sum.residency[i]);
+        else
+            seq_printf(m, "  [%llu, %llu): %llu\n", 1ULL << (i - 1), 1ULL << i, sum.residency[i]);
+    }
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(channel_stats);
+
+// Publica las estadísticas del canal en debugfs/ipc_channel/<nombre>
+static void channel_debugfs_add(struct ipc_channel *ch)
 {
-    struct item *it;
-    u32 n;
+    if (ipc_debugfs_dir && !ch->shm)
+        ch->debugfs = debugfs_create_file(channel_label(ch), 0444, ipc_debugfs_dir, ch,
+                                          &channel_stats_fops);
+}
+
+// debugfs se inicializa en el mismo nivel que el canal global, así que el
+// directorio se crea más tarde
+static int __init ipc_channel_debugfs_init(void)
+{
+    ipc_debugfs_dir = debugfs_create_dir("ipc_channel", NULL);
+    channel_debugfs_add(default_channel);
+    return 0;
+}
+late_initcall(ipc_channel_debugfs_init);
+
+// Registra un mensaje encolado (o entregado directo si handoff)
+static inline void channel_account_post(struct ipc_channel *ch, u32 prio, u32 len, u64 stamp,
+                                        bool handoff)
+{
+    this_cpu_inc(ch->stats->msgs_sent);
+    this_cpu_add(ch->stats->bytes_sent, len);
+    trace_ipc_channel_enqueue(channel_label(ch), prio, len, stamp, handoff);
+}
+
+// Registra un mensaje recibido y el tiempo que pasó en la cola
+static inline void channel_account_get(struct ipc_channel *ch, u32 prio, u32 len, u64 stamp)
+{
+    u64 residency = stamp ? ktime_get_ns() - stamp : 0;
+
+    this_cpu_inc(ch->stats->msgs_recv);
+    this_cpu_add(ch->stats->bytes_recv, len);
+    this_cpu_inc(ch->stats->residency[min_t(unsigned int, fls64(residency), IPC_HIST_BUCKETS - 1)]);
+    trace_ipc_channel_dequeue(channel_label(ch), prio, len, stamp, residency);
+}
+
+// Anillo de un nivel de prioridad. Se crea con la profundidad por defecto
+// del canal la primera vez que se envía a ese nivel.
+static struct ipc_ring *channel_ring(struct ipc_channel *ch, u32 prio)
+{
+    struct ipc_ring *r = smp_load_acquire(&ch->rings[prio]);
+
+    if (likely(r))
+        return r;
+
+    mutex_lock(&ch->lock);
+    r = ch->rings[prio];
+    if (!r) {
+        r = ring_alloc(ch->depth, ch->max_msg);
+        if (r)
+            smp_store_release(&ch->rings[prio], r);
+    }
+    mutex_unlock(&ch->lock);
+    return r ? r : ERR_PTR(-ENOMEM);
+}
+
+// Marca un nivel como no vacío después de publicar en él. La barrera ordena la
+// publicación antes de leer el bit (par con la de channel_claim_get), así que o
+// el emisor ve el bit limpio y lo vuelve a poner, o el receptor ve el mensaje.
+static inline void channel_mark_ready(struct ipc_channel *ch, u32 prio)
+{
+    smp_mb();
+    if (!test_bit(prio, &ch->ready))
+        set_bit(prio, &ch->ready);
+}
+
+// Reserva el siguiente mensaje del nivel de prioridad más alto con mensajes.
+// Retorna NULL si todos los niveles están vacíos.
+static struct slot *channel_claim_get(struct ipc_channel *ch, struct ipc_ring **pr, long *ppos, u32 *pprio)
+{
+    unsigned long ready;
+    struct ipc_ring *r;
+    struct slot *s;
+    u32 prio;
+
+    while ((ready = READ_ONCE(ch->ready))) {
+        prio = __fls(ready);
+        r = READ_ONCE(ch->rings[prio]);
+        s = ring_claim_get(r, ppos);
+        if (s) {
+            *pr = r;
+            *pprio = prio;
+            return s;
+        }
+
+        // Nivel vacío: se limpia su bit y se revisa de nuevo por si un emisor publicó entretanto
+        clear_bit(prio, &ch->ready);
+        smp_mb__after_atomic();
+        if (!ring_empty(r))
+            set_bit(prio, &ch->ready);
+    }
+    return NULL;
+}
+
+// Despierta al primer receptor estacionado para que revise el anillo.
+// Se usa cuando un mensaje terminó en el anillo en lugar de entregarse directo.
+static void channel_kick_parked(struct ipc_channel *ch)
+{
+    struct ipc_parked *p;
+
+    // Par con la barrera de channel_park: o vemos al receptor en la lista,
+    // o él ve el bit de ready
+    smp_mb();
+    if (list_empty(&ch->parked))
+        return;
+
+    spin_lock(&ch->park_lock);
+    p = list_first_entry_or_null(&ch->parked, struct ipc_parked, node);
+    if (p)
+        wake_up_process(p->task);
+    spin_unlock(&ch->park_lock);
+}
+
+// Despierta a todos los receptores estacionados (al cerrar el canal)
+static void channel_wake_parked(struct ipc_channel *ch)
+{
+    struct ipc_parked *p;
+
+    spin_lock(&ch->park_lock);
+    list_for_each_entry(p, &ch->parked, node)
+        wake_up_process(p->task);
+    spin_unlock(&ch->park_lock);
+}
+
+// Entrega un mensaje directo al primer receptor estacionado: se copia desde el
+// buffer del emisor a las páginas fijadas del receptor y se despierta solo a
+// ese proceso. Retorna -EAGAIN si no hay receptores estacionados.
+static int channel_handoff(struct ipc_channel *ch, const char __user *dat, u32 len, u32 prio)
+{
+    struct task_struct *task;
+    struct ipc_parked *p;
+    struct iov_iter iter;
+    size_t left, off, n;
+    unsigned int i;
+    int ret;
+
+    spin_lock(&ch->park_lock);
+    p = list_first_entry_or_null(&ch->parked, struct ipc_parked, node);
+    if (!p) {
+        spin_unlock(&ch->park_lock);
+        return -EAGAIN;
+    }
+    list_del(&p->node);
+    atomic_set(&p->state, PARK_CLAIMED);
+    spin_unlock(&ch->park_lock);
+
+    // Fuera de la lista el receptor espera a PARK_DONE, así que p sigue vivo
+    left = min(len, p->len);
+    off = p->offset;
+    ret = import_ubuf(ITER_SOURCE, (void __user *)dat, left, &iter);
+    for (i = 0; !ret && left; i++) {
+        n = min_t(size_t, PAGE_SIZE - off, left);
+        if (copy_page_from_iter(p->pages[i], off, n, &iter) != n)
+            ret = -EFAULT;
+        left -= n;
+        off = 0;
+    }
+
+    // El receptor vuelve a esperar si la copia falló
+    p->ret = ret ? 0 : min(len, p->len);
+    p->prio = prio;
+
+    task = p->task;
+    get_task_struct(task);
+    atomic_set_release(&p->state, PARK_DONE);
+    wake_up_process(task);
+    put_task_struct(task);
+
+    if (ret)
+        return ret;
+    channel_account_post(ch, prio, len, 0, true);
+    return len;
+}
+
+// Estaciona al receptor hasta que un emisor le entregue un mensaje directo,
+// aparezca un mensaje en el anillo, se cierre el canal o llegue deadline.
+// Retorna los bytes recibidos, 0 si hay que revisar el anillo otra vez o un error.
+static int channel_park(struct ipc_channel *ch, char __user *dat, u32 len, u32 *prio,
+                        ktime_t deadline)
+{
+    unsigned long addr = (unsigned long)dat;
+    struct ipc_parked p;
+    int pinned;
     int ret = 0;
 
-    if (!dat || len == 0)
-        return -EINVAL;
+    // Solo los mensajes que caben en una casilla se entregan directo
+    p.len = min(len, ch->max_msg);
+    p.offset = offset_in_page(addr);
+    p.nr_pages = DIV_ROUND_UP(p.offset + p.len, PAGE_SIZE);
+    p.user = NULL;
+    if (!capable(CAP_IPC_LOCK)) {
+        if (bulk_account(current_user(), p.nr_pages))
+            return -ENOMEM;
+        p.user = get_uid(current_user());
+    }
+
+    // FOLL_LONGTERM porque el receptor puede quedar estacionado indefinidamente;
+    // las páginas se cargan a RLIMIT_MEMLOCK igual que las de un mensaje grande
+    pinned = pin_user_pages_fast(addr & PAGE_MASK, p.nr_pages, FOLL_WRITE | FOLL_LONGTERM,
+                                 p.pages);
+    if (pinned != p.nr_pages) {
+        if (pinned > 0)
+            unpin_user_pages(p.pages, pinned);
+        bulk_unaccount(p.user, p.nr_pages);
+        return pinned < 0 ? pinned : -EFAULT;
+    }
+
+    p.task = current;
+    p.ret = 0;
+    atomic_set(&p.state, PARK_WAITING);
 
-    // Limitar tamaño del mensaje
-    n = (len > MAX_MSG_SIZE) ? MAX_MSG_SIZE : len;
+    spin_lock(&ch->park_lock);
+    list_add_tail(&p.node, &ch->parked);
+    spin_unlock(&ch->park_lock);
+    smp_mb();       // Par con channel_kick_parked
 
-    // Esperar a que haya espacio en la cola
-    while (1) {
-        mutex_lock(&queue_mutex);
-        if (current_queue_size < MAX_QUEUE_SIZE)
+    // Cada receptor duerme por su cuenta: los emisores despiertan a uno solo
+    for (;;) {
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (atomic_read_acquire(&p.state) != PARK_WAITING ||
+            READ_ONCE(ch->ready) || READ_ONCE(ch->closed))
             break;
-        mutex_unlock(&queue_mutex);
+        if (signal_pending(current)) {
+            ret = -ERESTARTSYS;
+            break;
+        }
+        if (deadline == IPC_FOREVER) {
+            schedule();
+        } else if (!schedule_hrtimeout(&deadline, HRTIMER_MODE_ABS)) {
+            ret = -ETIMEDOUT;
+            break;
+        }
+    }
+    __set_current_state(TASK_RUNNING);
 
-        if (wait_event_interruptible(post_wait_queue, current_queue_size < MAX_QUEUE_SIZE))
-            return -ERESTARTSYS;
+    spin_lock(&ch->park_lock);
+    if (atomic_read(&p.state) == PARK_WAITING) {
+        list_del(&p.node);
+        spin_unlock(&ch->park_lock);
+        unpin_user_pages(p.pages, p.nr_pages);
+        bulk_unaccount(p.user, p.nr_pages);
+        return ret;
     }
+    spin_unlock(&ch->park_lock);
 
-    // Reservar memoria en kernel
-    it = kmalloc(sizeof(*it), GFP_KERNEL);
-    if (!it) {
-        ret = -ENOMEM;
-        goto exit;
+    // Un emisor ya nos sacó de la lista: la copia es corta, se espera sin interrupciones
+    for (;;) {
+        set_current_state(TASK_UNINTERRUPTIBLE);
+        if (atomic_read_acquire(&p.state) == PARK_DONE)
+            break;
+        schedule();
     }
+    __set_current_state(TASK_RUNNING);
 
-    it->len = n;
+    unpin_user_pages_dirty_lock(p.pages, p.nr_pages, p.ret > 0);
+    bulk_unaccount(p.user, p.nr_pages);
+    if (p.ret > 0) {
+        *prio = p.prio;
+        channel_account_get(ch, p.prio, p.ret, 0);
+    }
+    return p.ret;
+}
 
-    // Copiar mensaje desde user space
-    if (copy_from_user(it->dat, dat, n)) {
-        kfree(it);
-        ret = -EFAULT;
-        goto exit;
+// Reserva un registro de la arena para len bytes, esperando hasta deadline
+static int channel_reserve(struct ipc_channel *ch, struct ipc_ring *r, u32 len, ktime_t deadline,
+                           long *prec)
+{
+    long ret;
+    u64 t0;
+
+    for (;;) {
+        if (READ_ONCE(ch->closed))
+            return -EPIPE;
+        *prec = arena_reserve(r, len);
+        if (*prec >= 0)
+            return 0;
+        if (deadline == IPC_NOWAIT)
+            return -EAGAIN;
+        wake_if_sleeping(&ch->get_wq);
+        t0 = ktime_get_ns();
+        ret = channel_wait_event(ch->post_wq, arena_fits(r, len) || READ_ONCE(ch->closed), deadline);
+        this_cpu_add(ch->stats->send_wait_ns, ktime_get_ns() - t0);
+        if (ret)
+            return ret;
     }
+}
 
-    // Agregar a la cola
-    list_add_tail(&it->node, &data_queue);
-    current_queue_size++;
+// Reserva una casilla libre, esperando hasta deadline. Antes de dormir se
+// despierta a los receptores por si los mensajes pendientes de este lote son
+// los que llenan el anillo.
+static int channel_claim_post(struct ipc_channel *ch, struct ipc_ring *r, ktime_t deadline,
+                              struct slot **ps, long *ppos)
+{
+    long ret;
+    u64 t0;
 
-exit:
-    mutex_unlock(&queue_mutex);
-    if (ret == 0)
-        wake_up_interruptible(&get_wait_queue);
-    return (ret == 0) ? n : ret;
+    for (;;) {
+        if (READ_ONCE(ch->closed))
+            return -EPIPE;
+        *ps = ring_claim_post(r, ppos);
+        if (*ps)
+            return 0;
+        if (deadline == IPC_NOWAIT)
+            return -EAGAIN;
+        wake_if_sleeping(&ch->get_wq);
+        t0 = ktime_get_ns();
+        ret = channel_wait_event(ch->post_wq, !ring_full(r) || READ_ONCE(ch->closed), deadline);
+        this_cpu_add(ch->stats->send_wait_ns, ktime_get_ns() - t0);
+        if (ret)
+            return ret;
+    }
 }
 
-// Syscall para recibir mensaje del canal
-SYSCALL_DEFINE2(ipc_channel_receive, char __user *, dat, u32, len)
+// Envía un mensaje mayor que max_msg: publica un descriptor de las páginas
+// fijadas del emisor y espera a que un receptor lo copie.
+static int channel_post_bulk(struct ipc_channel *ch, struct ipc_ring *r, u32 prio,
+                             const char __user *dat, u32 len, ktime_t deadline)
+{
+    struct ipc_bulk *b;
+    struct slot *s;
+    long pos;
+    long ret;
+    u64 stamp;
+
+    // Sin espera no se puede entregar de forma síncrona
+    if (deadline == IPC_NOWAIT)
+        return -EMSGSIZE;
+    if (len > IPC_MAX_BULK)
+        return -EMSGSIZE;
+
+    b = bulk_alloc(dat, len);
+    if (IS_ERR(b))
+        return PTR_ERR(b);
+
+    ret = channel_claim_post(ch, r, deadline, &s, &pos);
+    if (ret) {
+        bulk_free(b);
+        return ret;
+    }
+
+    s->len = len;
+    s->bulk = b;
+    s->stamp = stamp = ktime_get_ns();
+    ring_publish(s, pos);
+    channel_mark_ready(ch, prio);
+    channel_account_post(ch, prio, len, stamp, false);
+    if (ch->handoff)
+        channel_kick_parked(ch);
+    wake_if_sleeping(&ch->get_wq);
+
+    ret = channel_wait_event(ch->post_wq,
+                             bulk_finished(b) || READ_ONCE(ch->closed), deadline);
+    if (!bulk_finished(b)) {
+        // Si nadie lo tomó todavía se cancela y el receptor que lo encuentre lo libera
+        if (atomic_cmpxchg(&b->state, BULK_PENDING, BULK_CANCELLED) == BULK_PENDING)
+            return ret ? ret : -EPIPE;
+        // Un receptor ya está copiando: la copia termina pronto
+        wait_event(ch->post_wq, bulk_finished(b));
+    }
+
+    // Si el receptor pasó un buffer inválido el mensaje se perdió: el emisor
+    // lo sabe por ECOMM y puede reenviarlo
+    ret = atomic_read(&b->state) == BULK_DONE ? len : -ECOMM;
+    bulk_free(b);
+    return ret;
+}
+
+// Reserva una casilla (esperando hasta deadline), copia el mensaje y la publica.
+// No despierta a los receptores; eso lo hace quien llama, una vez por lote.
+static int channel_post(struct ipc_channel *ch, const char __user *dat, u32 len, u32 prio,
+                        ktime_t deadline)
+{
+    struct ipc_ring *r;
+    struct ipc_rec *rec;
+    struct slot *s;
+    long pos, rpos;
+    int ret;
+    u64 stamp;
+
+    r = channel_ring(ch, prio);
+    if (IS_ERR(r))
+        return PTR_ERR(r);
+
+    // Los mensajes mayores que max_msg van por las páginas fijadas
+    if (len > ch->max_msg)
+        return channel_post_bulk(ch, r, prio, dat, len, deadline);
+
+    // Con el anillo vacío y un receptor esperando, entregar directo.
+    // Si hay mensajes en cola se respeta su orden y se usa el anillo.
+    if (ch->handoff && !READ_ONCE(ch->ready) && !list_empty(&ch->parked)) {
+        ret = channel_handoff(ch, dat, len, prio);
+        if (ret != -EAGAIN)
+            return ret;
+    }
+
+    // Copiar el mensaje a la arena antes de tomar la casilla, así un fallo
+    // de copia no deja una casilla vacía en el anillo
+    ret = channel_reserve(ch, r, len, deadline, &rpos);
+    if (ret)
+        return ret;
+    rec = arena_rec(r, rpos);
+    if (copy_from_user(rec->dat, dat, len)) {
+        arena_free(r, rec);
+        return -EFAULT;
+    }
+
+    ret = channel_claim_post(ch, r, deadline, &s, &pos);
+    if (ret) {
+        arena_free(r, rec);
+        wake_if_sleeping(&ch->post_wq);
+        return ret;
+    }
+
+    s->len = len;
+    s->rec = rpos;
+    s->stamp = stamp = ktime_get_ns();
+    ring_publish(s, pos);
+    channel_mark_ready(ch, prio);
+    channel_account_post(ch, prio, len, stamp, false);
+    if (ch->handoff)
+        channel_kick_parked(ch);
+    return len;
+}
+
+// Toma el siguiente mensaje de mayor prioridad (esperando hasta deadline) y
+// lo copia al usuario. La prioridad del mensaje se devuelve en *prio.
+// Retorna 0 si el canal está cerrado y ya no quedan mensajes.
+// No despierta a los emisores; eso lo hace quien llama, una vez por lote.
+static int channel_get(struct ipc_channel *ch, char __user *dat, u32 len, u32 *prio,
+                       ktime_t deadline)
 {
-    struct item *it;
+    struct ipc_ring *r;
+    struct ipc_bulk *b;
+    struct ipc_rec *rec;
+    struct slot *s;
+    long pos;
     u32 n;
-    int ret = 0;
+    long ret;
+    u64 stamp, t0;
 
-    if (!dat || len == 0)
-        return -EINVAL;
+    // Esperar a que haya mensajes, saltando los mensajes grandes
+    // cancelados por su emisor
+    for (;;) {
+        s = channel_claim_get(ch, &r, &pos, prio);
+        if (!s) {
+            if (READ_ONCE(ch->closed))
+                return 0;
+            if (deadline == IPC_NOWAIT)
+                return -EAGAIN;
+            wake_if_sleeping(&ch->post_wq);
+            t0 = ktime_get_ns();
+            if (ch->handoff)
+                ret = channel_park(ch, dat, len, prio, deadline);
+            else
+                ret = channel_wait_event(ch->get_wq, READ_ONCE(ch->ready) || READ_ONCE(ch->closed),
+                                         deadline);
+            this_cpu_add(ch->stats->recv_wait_ns, ktime_get_ns() - t0);
+            if (ret)
+                return ret;
+            continue;
+        }
 
-    // Esperar a que haya mensajes
-    while (1) {
-        mutex_lock(&queue_mutex);
-        if (!list_empty(&data_queue))
+        b = s->bulk;
+        if (!b)
             break;
-        mutex_unlock(&queue_mutex);
 
-        if (wait_event_interruptible(get_wait_queue, !list_empty(&data_queue)))
-            return -ERESTARTSYS;
-    }
+        // Mensaje grande: la casilla se libera ya, el descriptor queda en nuestras manos
+        stamp = s->stamp;
+        s->bulk = NULL;
+        ring_release(r, s, pos);
+        if (atomic_cmpxchg(&b->state, BULK_PENDING, BULK_COPYING) != BULK_PENDING) {
+            bulk_free(b);
+            continue;
+        }
 
-    // Obtener primer mensaje
-    it = list_first_entry(&data_queue, struct item, node);
-    list_del(&it->node);
-    current_queue_size--;
+        ret = bulk_copy_to_user(b, dat, len);
+        atomic_set_release(&b->state, ret < 0 ? BULK_FAILED : BULK_DONE);
+        wake_up(&ch->post_wq);     // El emisor puede estar en espera no interrumpible
+        if (ret > 0)
+            channel_account_get(ch, *prio, ret, stamp);
+        return ret;
+    }
 
     // Limitar cantidad de datos copiados al buffer del usuario
-    n = (it->len > len) ? len : it->len;
+    n = (s->len > len) ? len : s->len;
+    rec = arena_rec(r, s->rec);
+    stamp = s->stamp;
+
+    // La casilla se libera antes de copiar; los datos siguen en la arena
+    ring_release(r, s, pos);
 
     // Copiar mensaje al espacio de usuario
-    if (copy_to_user(dat, it->dat, n)) {
-        kfree(it);
+    ret = copy_to_user(dat, rec->dat, n) ? -EFAULT : n;
+    arena_free(r, rec);
+    if (ret > 0)
+        channel_account_get(ch, *prio, ret, stamp);
+    return ret;
+}
+
+// Publica un mensaje en un canal de difusión. Se copia una sola vez y queda en
+// el anillo hasta que lo sobrescriba un mensaje posterior. Sin IPC_CHANNEL_LAG
+// el emisor espera a que el suscriptor más lento lea el mensaje más viejo.
+static int bcast_post(struct ipc_channel *ch, const char __user *dat, u32 len, u32 prio,
+                      ktime_t deadline)
+{
+    struct ipc_bcast_msg *m, *old;
+    u64 stamp, t0;
+    long ret;
+
+    if (len > ch->max_msg)
+        return -EMSGSIZE;
+
+    m = kmalloc(struct_size(m, dat, len), GFP_KERNEL_ACCOUNT);
+    if (!m)
+        return -ENOMEM;
+    if (copy_from_user(m->dat, dat, len)) {
+        kfree(m);
+        return -EFAULT;
+    }
+    refcount_set(&m->ref, 1);
+    m->len = len;
+    m->prio = prio;
+
+    for (;;) {
+        spin_lock(&ch->bcast_lock);
+        if (READ_ONCE(ch->closed)) {
+            spin_unlock(&ch->bcast_lock);
+            ret = -EPIPE;
+            break;
+        }
+        if (ch->bcast_lag || ch->bhead - bcast_min_cursor(ch) < ch->depth) {
+            m->stamp = stamp = ktime_get_ns();
+            old = ch->bmsgs[ch->bhead & (ch->depth - 1)];
+            ch->bmsgs[ch->bhead & (ch->depth - 1)] = m;
+            WRITE_ONCE(ch->bhead, ch->bhead + 1);
+            spin_unlock(&ch->bcast_lock);
+
+            bcast_msg_put(old);
+            channel_account_post(ch, prio, len, stamp, false);
+            return len;
+        }
+        spin_unlock(&ch->bcast_lock);
+
+        if (deadline == IPC_NOWAIT) {
+            ret = -EAGAIN;
+            break;
+        }
+        wake_if_sleeping(&ch->get_wq);
+        t0 = ktime_get_ns();
+        ret = channel_wait_event(ch->post_wq, !bcast_full(ch) || READ_ONCE(ch->closed), deadline);
+        this_cpu_add(ch->stats->send_wait_ns, ktime_get_ns() - t0);
+        if (ret)
+            break;
+    }
+
+    kfree(m);
+    return ret;
+}
+
+// Lee el siguiente mensaje de un suscriptor. Si el suscriptor se atrasó más que
+// la profundidad del canal (solo con IPC_CHANNEL_LAG), su cursor salta al
+// mensaje más viejo que sigue en el anillo y se retorna -EOVERFLOW una vez.
+static int bcast_get(struct ipc_channel *ch, struct ipc_sub *sub, char __user *dat, u32 len,
+                     u32 *prio, ktime_t deadline)
+{
+    struct ipc_bcast_msg *m;
+    u64 t0;
+    long ret;
+
+    // Un fd que solo publica no tiene cursor
+    if (!sub->subscribed)
+        return -EBADF;
+
+    for (;;) {
+        spin_lock(&ch->bcast_lock);
+        if (ch->bhead - sub->cursor > ch->depth) {
+            WRITE_ONCE(sub->cursor, ch->bhead - ch->depth);
+            spin_unlock(&ch->bcast_lock);
+            return -EOVERFLOW;
+        }
+        if (sub->cursor != ch->bhead) {
+            m = ch->bmsgs[sub->cursor & (ch->depth - 1)];
+            refcount_inc(&m->ref);
+            WRITE_ONCE(sub->cursor, sub->cursor + 1);
+            spin_unlock(&ch->bcast_lock);
+            break;
+        }
+        spin_unlock(&ch->bcast_lock);
+
+        if (READ_ONCE(ch->closed))
+            return 0;
+        if (deadline == IPC_NOWAIT)
+            return -EAGAIN;
+        t0 = ktime_get_ns();
+        ret = channel_wait_event(ch->get_wq,
+                                 READ_ONCE(ch->bhead) != READ_ONCE(sub->cursor) || READ_ONCE(ch->closed),
+                                 deadline);
+        this_cpu_add(ch->stats->recv_wait_ns, ktime_get_ns() - t0);
+        if (ret)
+            return ret;
+    }
+
+    // La copia al usuario se hace fuera del lock; la referencia mantiene vivo el mensaje
+    ret = min(len, m->len);
+    if (copy_to_user(dat, m->dat, ret))
         ret = -EFAULT;
-        goto exit;
+    *prio = m->prio;
+    if (ret > 0)
+        channel_account_get(ch, m->prio, ret, m->stamp);
+    bcast_msg_put(m);
+    return ret;
+}
+
+// Envía un lote de mensajes. Retorna cuántos mensajes se enviaron; si falla
+// alguno después del primero se retorna lo enviado hasta ese punto (igual que sendmmsg).
+static long channel_sendv(struct ipc_channel *ch, const struct ipc_msg_vec __user *uvec, u32 cnt,
+                          ktime_t deadline)
+{
+    struct ipc_msg_vec vec[VEC_CHUNK];
+    u32 done = 0, i, n;
+    int ret = 0;
+
+    while (done < cnt) {
+        n = min_t(u32, cnt - done, VEC_CHUNK);
+        if (copy_from_user(vec, uvec + done, n * sizeof(*vec))) {
+            ret = -EFAULT;
+            break;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (!vec[i].data_pointer || vec[i].len == 0 || vec[i].prio >= IPC_PRIO_LEVELS) {
+                ret = -EINVAL;
+                break;
+            }
+            if (ch->bcast)
+                ret = bcast_post(ch, u64_to_user_ptr(vec[i].data_pointer), vec[i].len,
+                                 vec[i].prio, deadline);
+            else
+                ret = channel_post(ch, u64_to_user_ptr(vec[i].data_pointer), vec[i].len,
+                                   vec[i].prio, deadline);
+            if (ret < 0)
+                break;
+            done++;
+        }
+        if (ret < 0)
+            break;
+    }
+
+    // Un solo despertar para todo el lote
+    if (done)
+        wake_if_sleeping(&ch->get_wq);
+    return done ? done : ret;
+}
+
+// Recibe un lote de mensajes. Espera (hasta deadline) solo por el primero;
+// después toma los que ya estén en cola, hasta cnt, siempre el de mayor
+// prioridad primero. La longitud recibida y la prioridad de cada mensaje se
+// escriben en su descriptor. En canales de difusión sub es el suscriptor que lee.
+static long channel_recvv(struct ipc_channel *ch, struct ipc_sub *sub,
+                          struct ipc_msg_vec __user *uvec, u32 cnt, ktime_t deadline)
+{
+    ktime_t wait;
+
+    struct ipc_msg_vec vec[VEC_CHUNK];
+    u32 done = 0, i, n;
+    int ret = 0;
+
+    while (done < cnt) {
+        n = min_t(u32, cnt - done, VEC_CHUNK);
+        if (copy_from_user(vec, uvec + done, n * sizeof(*vec))) {
+            ret = -EFAULT;
+            break;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (!vec[i].data_pointer || vec[i].len == 0) {
+                ret = -EINVAL;
+                break;
+            }
+            wait = (done == 0 && i == 0) ? deadline : IPC_NOWAIT;
+            if (sub)
+                ret = bcast_get(ch, sub, u64_to_user_ptr(vec[i].data_pointer), vec[i].len,
+                                &vec[i].prio, wait);
+            else
+                ret = channel_get(ch, u64_to_user_ptr(vec[i].data_pointer), vec[i].len,
+                                  &vec[i].prio, wait);
+            if (ret <= 0)
+                break;
+            vec[i].len = ret;
+        }
+
+        // Devolver las longitudes de los mensajes recibidos en este bloque
+        if (i && copy_to_user(uvec + done, vec, i * sizeof(*vec)))
+            ret = -EFAULT;
+        done += i;
+        if (ret <= 0)
+            break;
+    }
+
+    // Un solo despertar para todo el lote
+    if (done)
+        wake_if_sleeping(&ch->post_wq);
+    return done ? done : ret;
+}
+
+// Syscall para enviar mensaje al canal global
+SYSCALL_DEFINE2(ipc_channel_send, const char __user *, dat, u32, len)
+{
+    int ret;
+
+    if (!dat || len == 0)
+        return -EINVAL;
+
+    ret = channel_post(default_channel, dat, len, 0, IPC_FOREVER);
+    wake_if_sleeping(&default_channel->get_wq);
+    return ret;
+}
+
+// Syscall para recibir mensaje del canal global
+SYSCALL_DEFINE2(ipc_channel_receive, char __user *, dat, u32, len)
+{
+    u32 prio;
+    int ret;
+
+    if (!dat || len == 0)
+        return -EINVAL;
+
+    ret = channel_get(default_channel, dat, len, &prio, IPC_FOREVER);
+    wake_if_sleeping(&default_channel->post_wq);
+    return ret;
+}
+
+// Calcula el límite de espera de una operación: IPC_NOWAIT si el fd tiene
+// O_NONBLOCK, el instante absoluto (CLOCK_MONOTONIC) de uts si se indicó,
+// o IPC_FOREVER.
+static int channel_deadline(struct fd f, const struct __kernel_timespec __user *uts, ktime_t *deadline)
+{
+    struct timespec64 ts;
+
+    if (fd_file(f) && (fd_file(f)->f_flags & O_NONBLOCK)) {
+        *deadline = IPC_NOWAIT;
+        return 0;
+    }
+    if (!uts) {
+        *deadline = IPC_FOREVER;
+        return 0;
+    }
+
+    if (get_timespec64(&ts, uts))
+        return -EFAULT;
+    if (!timespec64_valid(&ts))
+        return -EINVAL;
+
+    // Un límite ya vencido se trata como 1ns para retornar -ETIMEDOUT y no -EAGAIN
+    *deadline = max_t(ktime_t, timespec64_to_ktime(ts), 1);
+    return 0;
+}
+
+// Implementación común de las syscalls de envío/recepción vectorizada
+static long channel_xferv(int fd, struct ipc_msg_vec __user *uvec, u32 cnt,
+                          const struct __kernel_timespec __user *uts, bool send)
+{
+    struct ipc_channel *ch;
+    ktime_t deadline;
+    struct fd f;
+    long ret;
+
+    if (!uvec || cnt == 0 || cnt > MAX_VEC_COUNT)
+        return -EINVAL;
+
+    ch = channel_fdget(fd, &f);
+    if (IS_ERR(ch))
+        return PTR_ERR(ch);
+
+    ret = channel_deadline(f, uts, &deadline);
+    if (ret)
+        goto out;
+
+    // Los canales compartidos se escriben directamente desde el espacio de usuario
+    if (ch->shm)
+        ret = -EOPNOTSUPP;
+    else if (send)
+        ret = channel_sendv(ch, uvec, cnt, deadline);
+    else
+        ret = channel_recvv(ch, channel_sub(f), uvec, cnt, deadline);
+out:
+    fdput(f);
+    return ret;
+}
+
+// Syscall para enviar varios mensajes en una sola llamada
+SYSCALL_DEFINE3(ipc_channel_sendv, int, fd, const struct ipc_msg_vec __user *, uvec, u32, cnt)
+{
+    return channel_xferv(fd, (struct ipc_msg_vec __user *)uvec, cnt, NULL, true);
+}
+
+// Syscall para recibir varios mensajes en una sola llamada
+SYSCALL_DEFINE3(ipc_channel_recvv, int, fd, struct ipc_msg_vec __user *, uvec, u32, cnt)
+{
+    return channel_xferv(fd, uvec, cnt, NULL, false);
+}
+
+// Igual que ipc_channel_sendv pero esperando como máximo hasta abs_timeout
+// (absoluto, CLOCK_MONOTONIC). Con abs_timeout NULL espera sin límite.
+SYSCALL_DEFINE4(ipc_channel_timedsendv, int, fd, const struct ipc_msg_vec __user *, uvec, u32, cnt,
+                const struct __kernel_timespec __user *, abs_timeout)
+{
+    return channel_xferv(fd, (struct ipc_msg_vec __user *)uvec, cnt, abs_timeout, true);
+}
+
+// Igual que ipc_channel_recvv pero esperando como máximo hasta abs_timeout
+SYSCALL_DEFINE4(ipc_channel_timedrecvv, int, fd, struct ipc_msg_vec __user *, uvec, u32, cnt,
+                const struct __kernel_timespec __user *, abs_timeout)
+{
+    return channel_xferv(fd, uvec, cnt, abs_timeout, false);
+}
+
+// Syscall para crear un canal con nombre. Retorna un fd que lo referencia.
+SYSCALL_DEFINE4(ipc_channel_create, const char __user *, uname, u32, depth, u32, max_msg, int, flags)
+{
+    char name[IPC_NAME_MAX];
+    struct ipc_channel *ch;
+    int ret;
+
+    if (flags & ~IPC_CREATE_FLAGS)
+        return -EINVAL;
+    if ((flags & IPC_CHANNEL_SHM) && (flags & IPC_CHANNEL_HANDOFF))
+        return -EINVAL;
+    if ((flags & IPC_CHANNEL_BROADCAST) && (flags & (IPC_CHANNEL_SHM | IPC_CHANNEL_HANDOFF)))
+        return -EINVAL;
+    if ((flags & (IPC_CHANNEL_LAG | IPC_CHANNEL_SUBSCRIBE)) && !(flags & IPC_CHANNEL_BROADCAST))
+        return -EINVAL;
+    if (depth == 0 || depth > IPC_MAX_DEPTH || max_msg == 0 || max_msg > IPC_MAX_MSG)
+        return -EINVAL;
+    if ((flags & IPC_CHANNEL_SHM) ? !shm_size_ok(depth, max_msg) : !ring_size_ok(depth, max_msg))
+        return -E2BIG;
+
+    ret = channel_copy_name(name, uname);
+    if (ret)
+        return ret;
+
+    ch = channel_alloc(name, depth, max_msg, flags);
+    if (!ch)
+        return -ENOMEM;
+
+    ch->owner = current_euid();
+
+    // Registrar el nombre. La referencia inicial es la del registro.
+    mutex_lock(&channel_table_lock);
+    if (channel_lookup(name)) {
+        mutex_unlock(&channel_table_lock);
+        channel_put(ch);
+        return -EEXIST;
+    }
+    if (nr_channels >= IPC_MAX_CHANNELS) {
+        mutex_unlock(&channel_table_lock);
+        channel_put(ch);
+        return -ENOSPC;
+    }
+    nr_channels++;
+    hash_add(channel_table, &ch->node, full_name_hash(NULL, name, strlen(name)));
+    kref_get(&ch->ref);
+    channel_debugfs_add(ch);
+    mutex_unlock(&channel_table_lock);
+
+    // Si no se pudo crear el fd se deshace el registro
+    ret = channel_install_fd(ch, flags);
+    if (ret < 0) {
+        mutex_lock(&channel_table_lock);
+        WRITE_ONCE(ch->closed, true);
+        hash_del(&ch->node);
+        nr_channels--;
+        debugfs_remove(ch->debugfs);
+        ch->debugfs = NULL;
+        mutex_unlock(&channel_table_lock);
+        channel_put(ch);
+    }
+    return ret;
+}
+
+// Syscall para abrir un canal con nombre existente
+SYSCALL_DEFINE2(ipc_channel_open, const char __user *, uname, int, flags)
+{
+    char name[IPC_NAME_MAX];
+    struct ipc_channel *ch;
+    int ret;
+
+    if (flags & ~IPC_OPEN_FLAGS)
+        return -EINVAL;
+
+    ret = channel_copy_name(name, uname);
+    if (ret)
+        return ret;
+
+    mutex_lock(&channel_table_lock);
+    ch = channel_lookup(name);
+    if (ch)
+        kref_get(&ch->ref);
+    mutex_unlock(&channel_table_lock);
+    if (!ch)
+        return -ENOENT;
+    if ((flags & IPC_CHANNEL_SUBSCRIBE) && !ch->bcast) {
+        channel_put(ch);
+        return -EINVAL;
+    }
+
+    return channel_install_fd(ch, flags);
+}
+
+// Syscall para cerrar un canal con nombre. El nombre queda libre, los emisores
+// reciben -EPIPE y los receptores leen lo que quede y luego reciben 0.
+// El fd se sigue cerrando con close(). Solo puede cerrarlo quien lo creó
+// (mismo euid) o un proceso con CAP_IPC_OWNER, como en las colas System V.
+SYSCALL_DEFINE1(ipc_channel_close, int, fd)
+{
+    struct ipc_channel *ch;
+    struct fd f;
+    bool was_open;
+
+    if (fd == IPC_CHANNEL_DEFAULT)
+        return -EINVAL;
+
+    ch = channel_fdget(fd, &f);
+    if (IS_ERR(ch))
+        return PTR_ERR(ch);
+
+    if (!uid_eq(current_euid(), ch->owner) && !capable(CAP_IPC_OWNER)) {
+        fdput(f);
+        return -EPERM;
+    }
+
+    mutex_lock(&channel_table_lock);
+    was_open = !ch->closed;
+    if (was_open) {
+        WRITE_ONCE(ch->closed, true);
+        hash_del(&ch->node);
+        nr_channels--;
+        // El nombre puede volver a usarse, así que su archivo se quita ya
+        debugfs_remove(ch->debugfs);
+        ch->debugfs = NULL;
+        if (ch->shm)
+            WRITE_ONCE(ch->shm->closed, 1);
+    }
+    mutex_unlock(&channel_table_lock);
+
+    if (was_open) {
+        wake_up_interruptible_all(&ch->post_wq);
+        wake_up_interruptible_all(&ch->get_wq);
+        channel_wake_parked(ch);
+        channel_put(ch);    // Referencia del registro; el fd aún mantiene la suya
+    }
+
+    fdput(f);
+    return was_open ? 0 : -EALREADY;
+}
+
+// Syscall estilo futex para canales IPC_CHANNEL_SHM. El espacio de usuario
+// solo entra al kernel para dormir cuando el anillo está vacío o lleno, o para
+// despertar a quien duerme (indicado por data_waiters/space_waiters).
+// Las operaciones WAIT retornan en cuanto el contador cambia o el canal se cierra.
+SYSCALL_DEFINE3(ipc_channel_futex, int, fd, u32, op, u32, val)
+{
+    struct ipc_shm_header *h;
+    struct ipc_channel *ch;
+    struct fd f;
+    long ret = 0;
+
+    if (fd == IPC_CHANNEL_DEFAULT)
+        return -EINVAL;
+
+    ch = channel_fdget(fd, &f);
+    if (IS_ERR(ch))
+        return PTR_ERR(ch);
+
+    h = ch->shm;
+    if (!h) {
+        fdput(f);
+        return -EINVAL;
     }
 
-    kfree(it);
+    switch (op) {
+    case IPC_FUTEX_WAIT_DATA:
+        if (wait_event_interruptible(ch->get_wq, READ_ONCE(h->data_seq) != val || READ_ONCE(ch->closed)))
+            ret = -ERESTARTSYS;
+        break;
+    case IPC_FUTEX_WAIT_SPACE:
+        if (wait_event_interruptible(ch->post_wq, READ_ONCE(h->space_seq) != val || READ_ONCE(ch->closed)))
+            ret = -ERESTARTSYS;
+        break;
+    case IPC_FUTEX_WAKE_DATA:
+        wake_if_sleeping(&ch->get_wq);
+        break;
+    case IPC_FUTEX_WAKE_SPACE:
+        wake_if_sleeping(&ch->post_wq);
+        break;
+    default:
+        ret = -EINVAL;
+    }
+
+    fdput(f);
+    return ret;
+}
+
+// Syscall para fijar la capacidad de un nivel de prioridad antes de usarlo.
+// Cada nivel tiene su propio anillo, así que el tráfico masivo de un nivel no
+// puede ocupar las casillas de otro. El nivel 0 tiene la profundidad de
+// ipc_channel_create y los demás, si no se configuran, la misma.
+SYSCALL_DEFINE3(ipc_channel_set_prio_depth, int, fd, u32, prio, u32, depth)
+{
+    struct ipc_channel *ch;
+    struct ipc_ring *r;
+    struct fd f;
+    long ret = 0;
+
+    if (prio >= IPC_PRIO_LEVELS || depth == 0 || depth > IPC_MAX_DEPTH)
+        return -EINVAL;
+
+    ch = channel_fdget(fd, &f);
+    if (IS_ERR(ch))
+        return PTR_ERR(ch);
 
-exit:
-    mutex_unlock(&queue_mutex);
-    if (ret == 0)
-        wake_up_interruptible(&post_wait_queue);
-    return (ret == 0) ? n : ret;
+    if (ch->shm || ch->bcast) {
+        ret = -EOPNOTSUPP;
+        goto out;
+    }
+    if (!ring_size_ok(depth, ch->max_msg)) {
+        ret = -E2BIG;
+        goto out;
+    }
+
+    mutex_lock(&ch->lock);
+    if (ch->rings[prio]) {
+        ret = -EBUSY;           // El nivel ya está en uso
+    } else {
+        r = ring_alloc(depth, ch->max_msg);
+        if (r)
+            smp_store_release(&ch->rings[prio], r);
+        else
+            ret = -ENOMEM;
+    }
+    mutex_unlock(&ch->lock);
+out:
+    fdput(f);
+    return ret;
 }
@@ -6,124 +6,1563 @@
 #include <linux/uaccess.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
-#include <linux/kthread.h>
+#include <linux/workqueue.h>
+#include <linux/rhashtable.h>
+#include <linux/namei.h>
 #include <linux/wait.h>
 #include <linux/string.h>
+#include <linux/ctype.h>
+#include <linux/fsnotify_backend.h>
+#include <linux/moduleparam.h>
+#include <linux/xarray.h>
+#include <linux/ktime.h>
+#include <linux/sched/cputime.h>
+#include <linux/anon_inodes.h>
+#include <linux/poll.h>
+#include <linux/kref.h>
+#include <linux/spinlock.h>
+#include <linux/pagemap.h>
+#include <linux/highmem.h>
+#include <linux/math64.h>
+#include <linux/crc32.h>
+#include <linux/kdev_t.h>
+#include <linux/unaligned.h>
+#include <asm/word-at-a-time.h>
 
-static DEFINE_MUTEX(context_list_lock);
-static LIST_HEAD(context_list);
+#define LOG_WATCH_ICASE 0x1             // Búsqueda sin distinguir mayúsculas
+#define LOG_WATCH_FD    0x2             // Coincidencias también en un anillo leíble con log_watch_open
 
-static atomic_t id_counter = ATOMIC_INIT(1);
+#define LOG_WATCH_MAX_KEYWORD 128       // Por palabra, incluyendo el '\0'
+#define LOG_WATCH_MAX_KEYWORDS 4096     // Lista completa de palabras
+
+// Contextos en curso indexados por ID. registry_lock serializa el registro
+// con stop_log_watch, que suelta la referencia del registro: mientras se
+// tiene tomado, un contexto encontrado no desaparece. Para usarlo después de
+// soltar registry_lock se toma una referencia (ctx->ref).
+static DEFINE_MUTEX(registry_lock);
+static DEFINE_XARRAY_ALLOC1(log_watch_ids);
+static u32 next_id;
+
+// Estadísticas de un monitoreo, como las devuelve log_watch_query
+struct log_watch_info {
+    __u32 id;
+    __u32 nfiles;
+    __u64 bytes_scanned;        // Bytes leídos y revisados
+    __u64 lines_scanned;        // Líneas completas revisadas
+    __u64 matches;              // Entradas escritas al log central
+    __u64 backlog;              // Bytes escritos en los archivos que aún no se leen
+    __u64 scans;                // Pasadas del trabajo del contexto
+    __u64 last_scan_ns;         // Duración de la última pasada
+    __u64 cpu_ns;               // Tiempo de CPU total de las pasadas
+    __u64 dropped;              // Registros perdidos con el anillo lleno (LOG_WATCH_FD)
+};
+
+// Registro de una coincidencia, como se lee del fd de log_watch_open. El
+// texto de la línea no se copia: offset y len la ubican en el archivo.
+struct log_watch_rec {
+    __u64 offset;               // Posición de la línea en el archivo
+    __u64 time_ns;              // CLOCK_REALTIME de la lectura que la encontró
+    __u32 len;                  // Largo de la línea, sin el '\n'
+    __u32 file;                 // Índice del archivo en el monitoreo
+    __u32 keyword;              // Índice de la palabra que coincidió
+    __u32 reserved;
+};
+
+// Grupo fsnotify compartido por todos los contextos. Cada archivo monitoreado
+// tiene una marca en su inodo que programa la lectura de su contexto cuando se escribe.
+// Se crea con FSNOTIFY_GROUP_DUPS: varios contextos sobre el mismo archivo
+// ponen cada uno su marca en el inodo, y sin esa opción la segunda falla con EEXIST.
+static struct fsnotify_group *log_watch_group;
+
+// Workqueue compartida donde se leen los archivos de todos los contextos.
+// Cada contexto tiene un solo trabajo, y la workqueue nunca ejecuta el mismo
+// trabajo en dos CPUs a la vez, así que un contexto se procesa en serie.
+static struct workqueue_struct *log_watch_wq;
+
+// Workqueue sin CPU fija donde corren los segmentos de una lectura en
+// paralelo (ver scan_parallel).
+static struct workqueue_struct *log_watch_par_wq;
+
+// Ventana de agrupación en milisegundos: tras el primer aviso la lectura se
+// programa con este retraso, para que una ráfaga de escrituras se lea de una vez.
+// 0 lee en cuanto llega el aviso.
+static unsigned int batch_ms;
+module_param(batch_ms, uint, 0644);
+MODULE_PARM_DESC(batch_ms, "Latencia máxima (ms) para agrupar escrituras antes de leer");
+
+// Tamaño en KiB del buffer de lectura de cada contexto (mínimo 64). Se toma
+// al iniciar el monitoreo.
+#define LOG_WATCH_MIN_BUF_KB 64
+static unsigned int buf_kb = LOG_WATCH_MIN_BUF_KB;
+module_param(buf_kb, uint, 0644);
+MODULE_PARM_DESC(buf_kb, "Tamaño en KiB del buffer de lectura por contexto");
+
+// Tamaño del buffer de salida de cada contexto: se escribe al log central al
+// final de cada pasada o antes, si se llena
+#define LOG_WATCH_OUT_SIZE (64 * 1024)
+
+// Buscar directamente sobre el page cache de los archivos, sin copiarlos al
+// buffer del contexto. Con 0 se usa kernel_read, como antes.
+static bool page_cache_scan = true;
+module_param(page_cache_scan, bool, 0644);
+MODULE_PARM_DESC(page_cache_scan, "Buscar sobre el page cache sin copiar los archivos");
+
+// Un archivo con al menos parallel_mb MiB pendientes se revisa en segmentos
+// en varias CPUs. 0 lo desactiva.
+#define LOG_WATCH_MIN_SEG (8 << 20)     // Bytes mínimos por segmento
+#define LOG_WATCH_MAX_SEGS 64
+#define LOG_WATCH_PAR_OUT_MAX (16 << 20) // Mensajes de todos los segmentos de una pasada
+static unsigned int parallel_mb = 64;
+module_param(parallel_mb, uint, 0644);
+MODULE_PARM_DESC(parallel_mb, "MiB pendientes en un archivo para revisarlo en paralelo (0 = nunca)");
+
+// Segundos entre guardados del cursor de un monitoreo con
+// start_log_watch_cursor. También se guarda al detenerlo.
+static unsigned int cursor_sec = 5;
+module_param(cursor_sec, uint, 0644);
+MODULE_PARM_DESC(cursor_sec, "Segundos entre guardados del cursor de posiciones");
+
+// Registros del anillo de cada monitoreo con LOG_WATCH_FD. Se redondea a
+// potencia de dos y se toma al iniciar el monitoreo.
+#define LOG_WATCH_MIN_RING 64
+#define LOG_WATCH_MAX_RING (1 << 20)
+static unsigned int ring_records = 4096;
+module_param(ring_records, uint, 0644);
+MODULE_PARM_DESC(ring_records, "Registros del anillo de coincidencias por monitoreo (LOG_WATCH_FD)");
+
+struct log_mark;
+
+// Buscador de una palabra clave, compilado una vez al iniciar el monitoreo.
+// Usa Horspool y, si la palabra tiene un byte poco común, primero salta con
+// find_byte() a cada aparición de ese byte.
+struct lw_matcher {
+    u8 pat[LOG_WATCH_MAX_KEYWORD];  // En minúsculas si icase
+    u32 len;
+    u32 rare;                       // Posición del byte poco común, o len si no hay
+    bool icase;
+    u8 skip[256];                   // Desplazamiento de Horspool por byte
+};
+
+// Autómata de Aho-Corasick para varias palabras clave, como DFA completo.
+// Los bytes se agrupan en clases (cada byte usado en alguna palabra tiene la
+// suya, el resto comparte la clase 0 y '\n' tiene una que vuelve a la raíz),
+// así cada estado ocupa ncls entradas y la tabla suele caber en caché.
+// Cada entrada es (fila del estado destino << 1) | (el destino termina una
+// palabra), de modo que avanzar un byte es una sola lectura de la tabla.
+// Si las palabras empiezan con a lo más AC_MAX_START bytes distintos, desde
+// la raíz se salta directo al siguiente de esos bytes.
+#define AC_MAX_START 3
+
+struct lw_ac {
+    u16 cls[256];
+    u32 ncls;
+    u32 nstates;
+    u8 start[AC_MAX_START];
+    u32 nstart;                     // 0 = sin prefiltro
+    u32 *trans;                     // nstates * ncls entradas
+    u16 *out;                       // Palabra que termina en cada estado
+};
 
 // Estructura que representa un archivo a monitorear
 // Esto con el fin de poder leer varios archivos en un solo contexto
 struct log_file {
     struct file *file;
+    struct inode *inode;        // Clave en el índice por inodo del contexto
+    struct rhash_head node;
     char *path;
+    u32 idx;                    // Índice que llevan sus registros en el anillo
     loff_t last_pos;
+    bool dirty;                 // Se escribió desde la última lectura
+    struct log_mark *mark;
     struct list_head list;
 };
 
-// Estructura del contexto de monitoreo. Contiene toda la información necesaria para el hilo de monitoreo
-// - La lista de archivos a monitorear list_head files
+// Anillo de registros de coincidencias de un monitoreo con LOG_WATCH_FD.
+// Escribe solo el trabajo del contexto (head) y leen los fd de log_watch_open
+// (tail, con read_lock entre ellos). Con el anillo lleno el registro nuevo se
+// descarta y se cuenta en dropped; la lectura de los logs nunca se detiene
+// por un lector lento. Cada fd tiene una referencia, así que el anillo
+// sobrevive a stop_log_watch hasta que se lee lo que quedaba.
+struct lw_ring {
+    struct kref ref;
+    struct log_watch_rec *rec;
+    u32 mask;
+    u64 head;
+    u64 tail;
+    u64 dropped;
+    bool closed;                // El monitoreo se detuvo
+    struct mutex read_lock;
+    wait_queue_head_t wq;
+};
+
+struct thread_ctx;
+
+// Posición guardada de un archivo en el cursor
+struct lw_cursor {
+    u32 dev;
+    u64 ino;
+    loff_t offset;
+    const char *path;
+};
+
+// Estado de una lectura: dónde se copian los datos que no se revisan sobre
+// el page cache, dónde se acumulan las coincidencias y sus contadores. El
+// contexto tiene uno para sus pasadas; cada segmento de una lectura en
+// paralelo tiene el suyo, así las CPUs no comparten nada mientras buscan.
+struct lw_scan {
+    struct thread_ctx *ctx;
+    char *buf;                      // kernel_read y líneas partidas entre folios
+    size_t buf_size;
+    char *out;                      // Mensajes pendientes para el log central
+    size_t out_len;
+    size_t out_size;
+    size_t out_max;                 // out crece hasta aquí (= out_size: no crece)
+    struct log_watch_rec *recs;     // Registros retenidos de un segmento; NULL: al anillo
+    u32 nrecs;
+    u32 recs_size;
+    u32 recs_max;                   // recs crece hasta aquí
+    const char *scan_buf;           // Bloque que se está revisando
+    loff_t base;                    // Posición en el archivo de scan_buf[0]
+    u64 stamp;                      // Hora de la lectura en curso
+    u64 bytes_scanned;
+    u64 lines_scanned;
+    u64 matches;
+};
+
+// Estructura del contexto de monitoreo. Contiene toda la información necesaria para leer sus archivos
+// - La lista de archivos a monitorear list_head files, indexada por inodo en by_inode
 // - El archivo central de logs log_file
-// - La palabra clave a buscar keyword
-// - Un mutex para proteger el acceso a la lista de archivos lock
-// - Una wait queue para dormir el hilo waitq
-// Finalmente un ID único id
+// - Las palabras clave a buscar kw (una o varias)
+// - Un mutex para proteger el acceso a la lista de archivos lock, y un
+//   spinlock files_lock que además se toma al agregar o quitar, para que
+//   log_watch_query recorra la lista sin esperar a una pasada
+// - El trabajo que lee los archivos marcados scan_work, y cursor_work, que
+//   lo programa cuando toca guardar el cursor
+// - El estado de lectura reutilizado en cada pasada scan: buffer, mensajes
+//   pendientes para el log central y contadores
+// - Los mensajes de segmentos en paralelo que faltan por escribir pending
+// - El anillo de registros ring, con LOG_WATCH_FD
+// - El archivo cursor_file donde se guardan las posiciones, con
+//   start_log_watch_cursor, y lo leído de él al iniciar restore
+// - El buscador compilado: match con una palabra, ac con varias
+// - Los contadores que reporta log_watch_query (también en scan); los
+//   escribe solo el trabajo del contexto y se leen sin lock
+// Finalmente un ID único id y las referencias ref: una del registro y una
+// por cada llamada que lo usa sin registry_lock
 struct thread_ctx {
     u32 id;
-    struct list_head list;
+    struct kref ref;
     struct list_head files;
+    struct rhashtable by_inode;
+    u32 nfiles;
     struct mutex lock;
-    struct task_struct *thread;
-    wait_queue_head_t waitq;
-    bool stop;
-    struct file *log_file;
-    char keyword[128];
-    size_t keyword_len;
+    spinlock_t files_lock;
+    struct delayed_work scan_work;
+    struct delayed_work cursor_work;
+    struct lw_scan scan;
+    struct list_head pending;
+    struct file *log_file;          // NULL con LOG_WATCH_FD sin log central
+    struct lw_ring *ring;
+    struct file *cursor_file;
+    bool cursor_dirty;              // Alguna posición cambió desde el último guardado
+    unsigned long cursor_next;      // jiffies del siguiente guardado
+    char *cursor_snap;              // Contenido a guardar, armado con ctx->lock
+    size_t cursor_len;
+    struct lw_cursor *restore;      // Solo mientras se inicia el monitoreo
+    u32 nrestore;
+    char *restore_buf;
+    u32 next_idx;                   // Índice para el siguiente archivo agregado
+    char *keywords;                 // Palabras separadas por '\0'
+    const char **kw;
+    u32 nkw;
+    struct lw_matcher match;
+    struct lw_ac *ac;
+    u64 scans;
+    u64 last_scan_ns;
+    u64 cpu_ns;
 };
 
-// Hilo del kernel que ejecuta el monitoreo para un contexto específico.
-static int monitor_thread(void *data) {
-    struct thread_ctx *ctx = data;
+// Marca fsnotify sobre el inodo de un archivo monitoreado. Se libera aparte
+// del archivo porque fsnotify la suelta después de un periodo de gracia.
+struct log_mark {
+    struct fsnotify_mark fsn;
+    struct thread_ctx *ctx;
     struct log_file *fw;
-    
-    while (!kthread_should_stop() && !READ_ONCE(ctx->stop)) {
-        mutex_lock(&ctx->lock);
-        list_for_each_entry(fw, &ctx->files, list) {
-            monitor_file(ctx, fw);
-        }
-        mutex_unlock(&ctx->lock);
-        
-        wait_event_interruptible_timeout(ctx->waitq, READ_ONCE(ctx->stop) || kthread_should_stop(), msecs_to_jiffies(2000));
+};
+
+static void ring_free(struct kref *ref) {
+    struct lw_ring *ring = container_of(ref, struct lw_ring, ref);
+
+    kvfree(ring->rec);
+    kfree(ring);
+}
+
+static struct lw_ring *ring_alloc(void) {
+    u32 n = clamp_t(u32, READ_ONCE(ring_records), LOG_WATCH_MIN_RING, LOG_WATCH_MAX_RING);
+    struct lw_ring *ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+
+    if (!ring)
+        return NULL;
+    n = roundup_pow_of_two(n);
+    ring->rec = kvmalloc_array(n, sizeof(*ring->rec), GFP_KERNEL);
+    if (!ring->rec) {
+        kfree(ring);
+        return NULL;
+    }
+    ring->mask = n - 1;
+    kref_init(&ring->ref);
+    mutex_init(&ring->read_lock);
+    init_waitqueue_head(&ring->wq);
+    return ring;
+}
+
+// Agrega un registro. Solo la llama el trabajo del contexto; los lectores
+// lo ven cuando se publica head.
+static void ring_push(struct lw_ring *ring, const struct log_watch_rec *rec) {
+    u64 head = ring->head;
+
+    if (head - smp_load_acquire(&ring->tail) > ring->mask) {
+        WRITE_ONCE(ring->dropped, ring->dropped + 1);
+        return;
+    }
+    ring->rec[head & ring->mask] = *rec;
+    smp_store_release(&ring->head, head + 1);
+}
+
+static inline bool ring_empty(struct lw_ring *ring) {
+    return smp_load_acquire(&ring->head) == READ_ONCE(ring->tail);
+}
+
+// Lee registros completos. Bloquea si el anillo está vacío, salvo con
+// O_NONBLOCK; retorna 0 cuando el monitoreo se detuvo y ya no queda nada.
+static ssize_t ring_read(struct file *file, char __user *ubuf, size_t count, loff_t *ppos) {
+    struct lw_ring *ring = file->private_data;
+    size_t want = count / sizeof(struct log_watch_rec), done = 0, n;
+    u64 head, tail;
+    ssize_t ret;
+
+    if (!want)
+        return -EINVAL;
+
+    if (mutex_lock_interruptible(&ring->read_lock))
+        return -ERESTARTSYS;
+    while (ring_empty(ring)) {
+        mutex_unlock(&ring->read_lock);
+        if (READ_ONCE(ring->closed))
+            return 0;
+        if (file->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        ret = wait_event_interruptible(ring->wq, !ring_empty(ring) || READ_ONCE(ring->closed));
+        if (ret)
+            return ret;
+        if (mutex_lock_interruptible(&ring->read_lock))
+            return -ERESTARTSYS;
     }
+
+    // Se copia en a lo más dos tramos, por si los registros dan la vuelta
+    tail = ring->tail;
+    head = smp_load_acquire(&ring->head);
+    while (done < want && tail != head) {
+        n = min3(want - done, (size_t)(head - tail), (size_t)(ring->mask + 1 - (tail & ring->mask)));
+        if (copy_to_user(ubuf + done * sizeof(struct log_watch_rec), &ring->rec[tail & ring->mask],
+                         n * sizeof(struct log_watch_rec)))
+            break;
+        done += n;
+        tail += n;
+    }
+    smp_store_release(&ring->tail, tail);
+    mutex_unlock(&ring->read_lock);
+
+    return done ? done * sizeof(struct log_watch_rec) : -EFAULT;
+}
+
+static __poll_t ring_poll(struct file *file, struct poll_table_struct *wait) {
+    struct lw_ring *ring = file->private_data;
+    __poll_t mask = 0;
+
+    poll_wait(file, &ring->wq, wait);
+    if (!ring_empty(ring))
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if (READ_ONCE(ring->closed))
+        mask |= EPOLLIN | EPOLLRDNORM | EPOLLHUP;
+    return mask;
+}
+
+static int ring_release(struct inode *inode, struct file *file) {
+    struct lw_ring *ring = file->private_data;
+
+    kref_put(&ring->ref, ring_free);
     return 0;
 }
 
-// Escribe un mensaje de log en el archivo central
-static int write_to_central_log(struct thread_ctx *ctx, const char *src_path, const char *line, size_t len) {
-    size_t path_len = strlen(src_path);
-    size_t bufsize = path_len + ctx->keyword_len + len + 50;
-    char *buffer = kmalloc(bufsize, GFP_KERNEL);
-    if (!buffer) return -ENOMEM;
+static const struct file_operations log_watch_ring_fops = {
+    .owner   = THIS_MODULE,
+    .read    = ring_read,
+    .poll    = ring_poll,
+    .release = ring_release,
+    .llseek  = noop_llseek,
+};
 
-    size_t written = snprintf(buffer, bufsize, "%s - Palabra '%s' encontrada en el log '%.*s'\n",
-                              src_path, ctx->keyword, (int)len, line);
+// Agranda out para que quepan need bytes, sin pasar de out_max
+static int out_grow(struct lw_scan *s, size_t need) {
+    size_t size = max(s->out_size * 2, need);
+    char *out;
 
-    mutex_lock(&ctx->lock);
+    if (need > s->out_max)
+        return -ENOSPC;
+    size = min(size, s->out_max);
+    out = kvrealloc(s->out, size, GFP_KERNEL);
+    if (!out)
+        return -ENOMEM;
+    s->out = out;
+    s->out_size = size;
+    return 0;
+}
+
+// Hace lugar para un registro retenido, hasta recs_max (la parte del anillo
+// que le toca al segmento: más no cabría al pasarlos).
+static int recs_grow(struct lw_scan *s) {
+    u32 size = min(max(s->recs_size * 2, 256u), s->recs_max);
+    struct log_watch_rec *recs;
+
+    if (s->nrecs < s->recs_size)
+        return 0;
+    if (size <= s->recs_size)
+        return -ENOSPC;
+    recs = kvrealloc(s->recs, size * sizeof(*recs), GFP_KERNEL);
+    if (!recs)
+        return -ENOMEM;
+    s->recs = recs;
+    s->recs_size = size;
+    return 0;
+}
+
+// Reporta una línea que coincidió con la palabra kw. Agrega un mensaje a
+// s->out y, con LOG_WATCH_FD, un registro al anillo (o a s->recs en un
+// segmento en paralelo). No escribe al archivo; eso lo hace
+// flush_central_log fuera de ctx->lock.
+// Retorna -ENOSPC si el mensaje no cabe y hay que vaciar el buffer primero;
+// en ese caso la línea no se reporta todavía. Un mensaje que no cabe ni con
+// el buffer vacío se recorta.
+static int report_match(struct lw_scan *s, struct log_file *fw, u32 kw,
+                        const char *line, size_t len) {
+    struct thread_ctx *ctx = s->ctx;
+    size_t need = strlen(fw->path) + strlen(ctx->kw[kw]) + len + 48;
+
+    if (ctx->log_file && s->out_len + need > s->out_size &&
+        out_grow(s, s->out_len + need) && s->out_len)
+        return -ENOSPC;
+    if (ctx->ring && s->recs && recs_grow(s))
+        return -ENOSPC;
+
+    if (ctx->log_file)
+        s->out_len += scnprintf(s->out + s->out_len, s->out_size - s->out_len,
+                                "%s - Palabra '%s' encontrada en el log '%.*s'\n",
+                                fw->path, ctx->kw[kw], (int)len, line);
+
+    if (ctx->ring) {
+        struct log_watch_rec rec = {
+            .offset = s->base + (line - s->scan_buf),
+            .time_ns = s->stamp,
+            .len = len,
+            .file = fw->idx,
+            .keyword = kw,
+        };
+
+        if (s->recs)
+            s->recs[s->nrecs++] = rec;
+        else
+            ring_push(ctx->ring, &rec);
+    }
+
+    WRITE_ONCE(s->matches, s->matches + 1);
+    return 0;
+}
+
+static void write_central_log(struct thread_ctx *ctx, const char *buf, size_t len) {
     loff_t pos = ctx->log_file->f_pos;
-    int ret = kernel_write(ctx->log_file, buffer, written, &pos);
-    if (ret > 0) {
+    ssize_t ret;
+
+    ret = kernel_write(ctx->log_file, buf, len, &pos);
+    if (ret > 0)
         ctx->log_file->f_pos = pos;
-        ret = 0;
+    else
+        pr_warn_ratelimited("log_watch %u: no se pudo escribir el log central (%zd)\n", ctx->id, ret);
+}
+
+// Busca el siguiente byte c revisando una palabra de máquina por iteración
+// (mismo truco que strscpy para el byte cero). Retorna NULL si no hay.
+static const char *find_byte(const char *p, size_t len, u8 c) {
+    const struct word_at_a_time constants = WORD_AT_A_TIME_CONSTANTS;
+    const char *end = p + len;
+    unsigned long w, data;
+
+    while (end - p >= sizeof(unsigned long)) {
+        w = get_unaligned((const unsigned long *)p) ^ REPEAT_BYTE(c);
+        if (has_zero(w, &data, &constants)) {
+            data = prep_zero_mask(w, data, &constants);
+            data = create_zero_mask(data);
+            return p + find_zero(data);
+        }
+        p += sizeof(unsigned long);
     }
-    mutex_unlock(&ctx->lock);
+    return memchr(p, c, end - p);
+}
 
-    kfree(buffer);
+static inline const char *find_eol(const char *p, size_t len) {
+    return find_byte(p, len, '\n');
+}
+
+// Cuenta los '\n' de un bloque una palabra de máquina a la vez. A diferencia
+// de has_zero, la máscara marca exactamente los bytes que son '\n'.
+static size_t count_eol(const char *p, size_t len) {
+    const unsigned long lo = REPEAT_BYTE(0x7f);
+    unsigned long w;
+    size_t n = 0;
+
+    for (; len >= sizeof(unsigned long); p += sizeof(unsigned long), len -= sizeof(unsigned long)) {
+        w = get_unaligned((const unsigned long *)p) ^ REPEAT_BYTE('\n');
+        n += hweight_long(~(((w & lo) + lo) | w | lo));
+    }
+    for (; len; p++, len--)
+        n += *p == '\n';
+    return n;
+}
+
+// Como find_byte, pero busca cualquiera de los n bytes de set
+static const char *find_any(const char *p, size_t len, const u8 *set, u32 n) {
+    const struct word_at_a_time constants = WORD_AT_A_TIME_CONSTANTS;
+    const char *end = p + len;
+    unsigned long w, data;
+    u32 i;
+
+    while (end - p >= sizeof(unsigned long)) {
+        w = get_unaligned((const unsigned long *)p);
+        for (i = 0; i < n; i++) {
+            if (has_zero(w ^ REPEAT_BYTE(set[i]), &data, &constants))
+                goto bytes;
+        }
+        p += sizeof(unsigned long);
+    }
+bytes:
+    // La palabra actual tiene alguno, o quedan menos de sizeof(long) bytes
+    for (; p < end; p++) {
+        for (i = 0; i < n; i++) {
+            if ((u8)*p == set[i])
+                return p;
+        }
+    }
+    return NULL;
+}
+
+// Frecuencia aproximada de un byte en texto de logs (mayor = más común)
+static u8 byte_rank(u8 c) {
+    if (c == ' ')
+        return 255;
+    if (c && strchr("etaoinsrhl", c))
+        return 200;
+    if (islower(c))
+        return 160;
+    if (isdigit(c))
+        return 150;
+    if (c && strchr(":.-/[]=,_()", c))
+        return 120;
+    if (isupper(c))
+        return 60;
+    return 20;
+}
+
+// Compila la palabra clave. Con icase el prefiltro solo usa bytes que no
+// son letras, porque find_byte() busca un único valor.
+static void lw_compile(struct lw_matcher *m, const char *kw, size_t len, bool icase) {
+    u32 i, best = 256;
+
+    m->len = len;
+    m->icase = icase;
+    m->rare = len;
+    for (i = 0; i < len; i++)
+        m->pat[i] = icase ? tolower(kw[i]) : kw[i];
+
+    for (i = 0; i < 256; i++)
+        m->skip[i] = len;
+    for (i = 0; i + 1 < len; i++) {
+        m->skip[m->pat[i]] = len - 1 - i;
+        if (icase)
+            m->skip[toupper(m->pat[i])] = len - 1 - i;
+    }
+
+    // Byte menos común de la palabra; solo sirve si es realmente raro
+    for (i = 0; i < len; i++) {
+        if (icase && isalpha(m->pat[i]))
+            continue;
+        if (byte_rank(m->pat[i]) < best) {
+            best = byte_rank(m->pat[i]);
+            m->rare = i;
+        }
+    }
+    if (best > 150)
+        m->rare = len;
+}
+
+static inline bool lw_equal(const struct lw_matcher *m, const char *s) {
+    u32 i;
+
+    if (!m->icase)
+        return !memcmp(s, m->pat, m->len);
+    for (i = 0; i < m->len; i++) {
+        if (tolower(s[i]) != m->pat[i])
+            return false;
+    }
+    return true;
+}
+
+static const char *lw_horspool(const struct lw_matcher *m, const char *s, size_t n) {
+    const char *p = s, *last;
+    u8 c, tail = m->pat[m->len - 1];
+
+    if (n < m->len)
+        return NULL;
+    for (last = s + n - m->len; p <= last; p += m->skip[c]) {
+        c = p[m->len - 1];
+        if ((m->icase ? tolower(c) : c) == tail && lw_equal(m, p))
+            return p;
+    }
+    return NULL;
+}
+
+// Retorna la primera aparición de la palabra en s, o NULL. Si el prefiltro
+// da demasiados candidatos falsos se sigue solo con Horspool.
+static const char *lw_find(const struct lw_matcher *m, const char *s, size_t n) {
+    const char *p = s, *hit;
+    size_t fails = 0;
+
+    if (!m->len)
+        return s;
+    if (n < m->len)
+        return NULL;
+    if (m->rare == m->len)
+        return lw_horspool(m, s, n);
+
+    while (p + m->len <= s + n) {
+        hit = find_byte(p + m->rare, s + n - m->len + 1 - p, m->pat[m->rare]);
+        if (!hit)
+            return NULL;
+        p = hit - m->rare;
+        if (lw_equal(m, p))
+            return p;
+        p++;
+        if (++fails > 8 && (size_t)(p - s) < fails * 16)
+            return lw_horspool(m, p, s + n - p);
+    }
+    return NULL;
+}
+
+#define AC_NONE U32_MAX
+
+// Construye el autómata de Aho-Corasick para las palabras kw (ninguna vacía).
+// Primero arma el trie con AC_NONE en las transiciones que faltan y luego,
+// en orden BFS, las completa con las del estado de falla.
+static struct lw_ac *ac_compile(const char **kw, u32 nkw, bool icase) {
+    struct lw_ac *ac;
+    u32 *fail = NULL, *queue = NULL;
+    u32 i, j, c, s, next, max_states = 1, head = 0, tail = 0;
+    const u8 *w;
+    u8 b;
+
+    ac = kzalloc(sizeof(*ac), GFP_KERNEL);
+    if (!ac)
+        return NULL;
+
+    // Clases de bytes: 0 = no aparece en ninguna palabra, 1 = '\n'
+    ac->ncls = 2;
+    ac->cls['\n'] = 1;
+    for (i = 0; i < nkw; i++) {
+        for (w = (const u8 *)kw[i]; *w; w++) {
+            b = icase ? tolower(*w) : *w;
+            if (!ac->cls[b]) {
+                ac->cls[b] = ac->ncls++;
+                if (icase)
+                    ac->cls[toupper(b)] = ac->cls[b];
+            }
+            max_states++;
+        }
+    }
+
+    ac->trans = kvmalloc_array((size_t)max_states * ac->ncls, sizeof(u32), GFP_KERNEL);
+    ac->out = kvmalloc_array(max_states, sizeof(u16), GFP_KERNEL);
+    fail = kvmalloc_array(max_states, sizeof(u32), GFP_KERNEL);
+    queue = kvmalloc_array(max_states, sizeof(u32), GFP_KERNEL);
+    if (!ac->trans || !ac->out || !fail || !queue)
+        goto err;
+    memset(ac->trans, 0xff, (size_t)max_states * ac->ncls * sizeof(u32));
+    memset(ac->out, 0xff, max_states * sizeof(u16));
+
+    // Bytes con los que empiezan las palabras, para el prefiltro
+    for (i = 0; i < nkw && ac->nstart <= AC_MAX_START; i++) {
+        b = icase ? tolower(kw[i][0]) : kw[i][0];
+        for (j = 0; j < 2; j++, b = toupper(b)) {
+            if (memchr(ac->start, b, min(ac->nstart, AC_MAX_START)))
+                continue;
+            if (ac->nstart < AC_MAX_START)
+                ac->start[ac->nstart] = b;
+            ac->nstart++;
+            if (!icase)
+                break;
+        }
+    }
+    if (ac->nstart > AC_MAX_START)
+        ac->nstart = 0;
+
+    // Trie. Si una palabra se repite se queda la primera.
+    ac->nstates = 1;
+    for (i = 0; i < nkw; i++) {
+        s = 0;
+        for (w = (const u8 *)kw[i]; *w; w++) {
+            c = ac->cls[icase ? tolower(*w) : *w];
+            if (ac->trans[s * ac->ncls + c] == AC_NONE)
+                ac->trans[s * ac->ncls + c] = ac->nstates++;
+            s = ac->trans[s * ac->ncls + c];
+        }
+        if (ac->out[s] == U16_MAX)
+            ac->out[s] = i;
+    }
+
+    // Transiciones de la raíz: lo que no está en el trie vuelve a la raíz
+    for (c = 0; c < ac->ncls; c++) {
+        next = ac->trans[c];
+        if (next == AC_NONE) {
+            ac->trans[c] = 0;
+        } else {
+            fail[next] = 0;
+            queue[tail++] = next;
+        }
+    }
+
+    while (head < tail) {
+        s = queue[head++];
+        for (c = 0; c < ac->ncls; c++) {
+            next = ac->trans[s * ac->ncls + c];
+            if (next == AC_NONE) {
+                ac->trans[s * ac->ncls + c] = ac->trans[fail[s] * ac->ncls + c];
+                continue;
+            }
+            fail[next] = ac->trans[fail[s] * ac->ncls + c];
+            // Un estado también termina las palabras de su estado de falla
+            if (ac->out[next] == U16_MAX)
+                ac->out[next] = ac->out[fail[next]];
+            queue[tail++] = next;
+        }
+    }
+
+    // Codificar las entradas como fila del destino más la marca de palabra
+    for (j = 0; j < ac->nstates * ac->ncls; j++) {
+        next = ac->trans[j];
+        ac->trans[j] = (next * ac->ncls) << 1 | (ac->out[next] != U16_MAX);
+    }
+
+    kvfree(fail);
+    kvfree(queue);
+    return ac;
+
+err:
+    kvfree(fail);
+    kvfree(queue);
+    kvfree(ac->trans);
+    kvfree(ac->out);
+    kfree(ac);
+    return NULL;
+}
+
+static void ac_free(struct lw_ac *ac) {
+    if (!ac)
+        return;
+    kvfree(ac->trans);
+    kvfree(ac->out);
+    kfree(ac);
+}
+
+// Recorre un bloque de líneas completas con el autómata, un byte a la vez.
+// '\n' lleva a la raíz, así que no hace falta cortar las líneas antes; al
+// encontrar una palabra se ubica la línea, se escribe con la palabra que la
+// marcó y se sigue desde la línea siguiente.
+// Retorna los bytes procesados: len, o el inicio de la línea que no cupo en
+// el buffer de salida.
+static size_t ac_scan(struct lw_scan *s, struct log_file *fw, const char *buf, size_t len) {
+    const struct lw_ac *ac = s->ctx->ac;
+    const char *start, *eol;
+    u32 row = 0, e;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (!row && ac->nstart) {
+            start = find_any(buf + i, len - i, ac->start, ac->nstart);
+            if (!start)
+                break;
+            i = start - buf;
+        }
+        e = ac->trans[row + ac->cls[(u8)buf[i]]];
+        row = e >> 1;
+        if (likely(!(e & 1)))
+            continue;
+
+        start = buf + i;
+        while (start > buf && start[-1] != '\n')
+            start--;
+        eol = find_eol(buf + i, len - i);
+        if (!eol)
+            eol = buf + len;
+        if (report_match(s, fw, ac->out[row / ac->ncls], start, eol - start))
+            return start - buf;
+
+        i = eol - buf;
+        row = 0;
+    }
+    return len;
+}
+
+// Separa la lista de palabras (una por línea) y compila el buscador. Con
+// una sola palabra se usa lw_matcher; con varias, Aho-Corasick.
+static int compile_keywords(struct thread_ctx *ctx, bool icase) {
+    char *p, *word;
+    u32 n = 0;
+
+    for (p = ctx->keywords; *p; p++)
+        n += (*p == '\n');
+    ctx->kw = kcalloc(n + 1, sizeof(*ctx->kw), GFP_KERNEL);
+    if (!ctx->kw)
+        return -ENOMEM;
+
+    p = ctx->keywords;
+    while ((word = strsep(&p, "\n"))) {
+        if (!*word && n)
+            continue;           // Líneas vacías en una lista
+        if (strlen(word) >= LOG_WATCH_MAX_KEYWORD)
+            return -EINVAL;
+        ctx->kw[ctx->nkw++] = word;
+    }
+    if (!ctx->nkw)
+        return -EINVAL;
+
+    if (ctx->nkw == 1) {
+        lw_compile(&ctx->match, ctx->kw[0], strlen(ctx->kw[0]), icase);
+        return 0;
+    }
+    ctx->ac = ac_compile(ctx->kw, ctx->nkw, icase);
+    return ctx->ac ? 0 : -ENOMEM;
+}
+
+// Largo del bloque hasta el último '\n' inclusive, o 0 si no hay ninguno.
+// La última línea casi siempre es corta, así que se busca hacia atrás.
+static size_t complete_lines(const char *buf, size_t len) {
+    while (len && buf[len - 1] != '\n')
+        len--;
+    return len;
+}
+
+// Revisa línea por línea un bloque de líneas completas y escribe en el log
+// central solo las que contienen la palabra clave. Retorna los bytes
+// procesados, como ac_scan.
+static size_t scan_lines(struct lw_scan *s, struct log_file *fw, const char *buf, size_t len) {
+    const char *p = buf, *end = buf + len, *eol;
+
+    if (s->ctx->ac)
+        return ac_scan(s, fw, buf, len);
+
+    while (p < end) {
+        eol = find_eol(p, end - p);
+        if (!eol)
+            eol = end;
+        if (lw_find(&s->ctx->match, p, eol - p) &&
+            report_match(s, fw, 0, p, eol - p))
+            return p - buf;
+        p = eol + 1;
+    }
+    return len;
+}
+
+// Revisa un bloque de líneas completas que empieza en la posición base del
+// archivo, esté en el buffer del contexto o en el page cache. Actualiza los
+// contadores y retorna los bytes procesados, como scan_lines.
+static size_t scan_block(struct lw_scan *s, struct log_file *fw, const char *buf, size_t len,
+                         loff_t base) {
+    size_t done;
+
+    s->scan_buf = buf;
+    s->base = base;
+    if (s->ctx->ring)
+        s->stamp = ktime_get_real_ns();
+    done = scan_lines(s, fw, buf, len);
+    WRITE_ONCE(s->bytes_scanned, s->bytes_scanned + done);
+    WRITE_ONCE(s->lines_scanned, s->lines_scanned + count_eol(buf, done));
+    return done;
+}
+
+// Lee lo nuevo del archivo con kernel_read al buffer del contexto. Se usa
+// con archivos sin page cache (o con page_cache_scan = 0).
+// Se lee por bloques del buffer hasta alcanzar el tamaño que tenía el
+// archivo al empezar; lo escrito después llega con otro aviso.
+// Solo se procesan líneas completas: la línea final sin '\n' no avanza
+// last_pos y se vuelve a leer, ya completa, en la siguiente lectura. Una
+// línea más larga que el buffer se procesa en pedazos del tamaño del buffer.
+// Retorna -ENOSPC si se detuvo porque el buffer de salida se llenó; last_pos
+// queda en la línea que no cupo.
+static int scan_file_read(struct lw_scan *s, struct log_file *fw) {
+    loff_t size = i_size_read(file_inode(fw->file));
+    loff_t pos = fw->last_pos, start;
+    ssize_t read_bytes = 0;
+    size_t len, done;
+
+    while (pos < size) {
+        start = pos;
+        read_bytes = kernel_read(fw->file, s->buf, min_t(loff_t, s->buf_size, size - pos), &pos);
+        if (read_bytes <= 0) {
+            pos = start;
+            break;
+        }
+
+        len = complete_lines(s->buf, read_bytes);
+        if (!len) {
+            // Línea incompleta: esperar a que llegue su final
+            if (read_bytes < s->buf_size) {
+                pos = start;
+                break;
+            }
+            len = read_bytes;
+        }
+
+        done = scan_block(s, fw, s->buf, len, start);
+        pos = start + done;
+        if (done < len) {
+            WRITE_ONCE(fw->last_pos, pos);
+            return -ENOSPC;
+        }
+        cond_resched();
+    }
+    WRITE_ONCE(fw->last_pos, pos);
+
+    return read_bytes < 0 ? read_bytes : 0;
+}
+
+// Obtiene el folio del page cache con el byte index << PAGE_SHIFT, ya
+// leído. Si no está, se lee con readahead hasta el final de lo pendiente.
+static struct folio *get_scan_folio(struct log_file *fw, pgoff_t index, pgoff_t last) {
+    struct address_space *mapping = fw->file->f_mapping;
+    struct folio *folio = filemap_get_folio(mapping, index);
+
+    if (!IS_ERR(folio)) {
+        if (folio_test_uptodate(folio))
+            return folio;
+        folio_put(folio);
+    }
+    page_cache_sync_readahead(mapping, &fw->file->f_ra, fw->file, index, last - index + 1);
+    return read_mapping_folio(mapping, index, fw->file);
+}
+
+// Lee lo nuevo del archivo directamente del page cache, folio por folio,
+// sin copiarlo: el buscador corre sobre el folio mapeado. Solo se copian al
+// buffer del contexto las líneas partidas entre dos folios (o dos páginas,
+// con highmem), y de las coincidencias solo la línea que va al log central.
+// Las reglas de líneas incompletas, líneas largas y -ENOSPC son las mismas
+// de scan_file_read.
+// Revisa [pos, size) y deja en *stop hasta dónde quedó revisado: size, el
+// inicio de la última línea sin terminar o la línea que no cupo.
+static int scan_file_mapped(struct lw_scan *s, struct log_file *fw, loff_t pos, loff_t size,
+                            loff_t *stop) {
+    loff_t carry_pos = 0;
+    size_t carry = 0, off, seg, len, take, done;
+    const char *p, *end, *eol;
+    struct folio *folio;
+    char *kaddr;
+    int ret = 0;
+
+    while (pos < size) {
+        folio = get_scan_folio(fw, pos >> PAGE_SHIFT, (size - 1) >> PAGE_SHIFT);
+        if (IS_ERR(folio)) {
+            ret = PTR_ERR(folio);
+            break;
+        }
+
+        off = pos - folio_pos(folio);
+        seg = min_t(loff_t, folio_size(folio) - off, size - pos);
+        if (folio_test_highmem(folio))
+            seg = min_t(size_t, seg, PAGE_SIZE - offset_in_page(off));
+        kaddr = kmap_local_folio(folio, off);
+        p = kaddr;
+        end = kaddr + seg;
+
+        // 1. Completar en el buffer la línea que empezó en el tramo anterior
+        if (carry) {
+            eol = find_eol(p, end - p);
+            take = min_t(size_t, eol ? eol + 1 - p : end - p, s->buf_size - carry);
+            memcpy(s->buf + carry, p, take);
+            carry += take;
+            p += take;
+            if ((eol && p > eol) || carry == s->buf_size) {
+                done = scan_block(s, fw, s->buf, carry, carry_pos);
+                if (done < carry) {
+                    pos = carry_pos + done;
+                    ret = -ENOSPC;
+                    goto unmap;
+                }
+                carry = 0;
+            }
+        }
+
+        if (!carry) {
+            // 2. Las líneas completas del tramo se revisan en el mismo folio
+            len = complete_lines(p, end - p);
+            // Del final sin '\n' solo se copia lo que cabe en el buffer; lo
+            // anterior se revisa aquí mismo como pedazo de una línea larga
+            if (end - p - len > s->buf_size)
+                len = end - p - s->buf_size;
+            if (len) {
+                done = scan_block(s, fw, p, len, pos + (p - kaddr));
+                if (done < len) {
+                    pos += p - kaddr + done;
+                    ret = -ENOSPC;
+                    goto unmap;
+                }
+                p += len;
+            }
+
+            // 3. El resto es el inicio de una línea que sigue en el próximo tramo
+            if (p < end) {
+                carry_pos = pos + (p - kaddr);
+                carry = end - p;
+                memcpy(s->buf, p, carry);
+            }
+        }
+        pos += seg;
+unmap:
+        kunmap_local(kaddr);
+        folio_put(folio);
+        if (ret)
+            break;
+        cond_resched();
+    }
+
+    // Una línea sin terminar se vuelve a leer desde su inicio
+    if (ret != -ENOSPC && carry)
+        pos = carry_pos;
+    *stop = pos;
     return ret;
 }
 
-// Busca la palabra clave en un buffer de texto
-static int contains_keyword(const char *line, size_t len, const char *keyword, size_t kwlen) {
-    if (len < kwlen) return 0;
-    for (size_t i = 0; i <= len - kwlen; i++) {
-        if (!memcmp(line + i, keyword, kwlen))
-            return 1;
+// Primera posición en [at, limit) donde empieza una línea (at mismo si el
+// byte anterior es '\n'), o limit si no hay.
+static loff_t next_line(struct log_file *fw, loff_t at, loff_t limit) {
+    loff_t pos = at - 1;
+    struct folio *folio;
+    const char *kaddr, *eol;
+    size_t off, seg;
+
+    while (pos < limit) {
+        folio = get_scan_folio(fw, pos >> PAGE_SHIFT, (limit - 1) >> PAGE_SHIFT);
+        if (IS_ERR(folio))
+            return limit;
+        off = pos - folio_pos(folio);
+        seg = min_t(loff_t, folio_size(folio) - off, limit - pos);
+        if (folio_test_highmem(folio))
+            seg = min_t(size_t, seg, PAGE_SIZE - offset_in_page(off));
+        kaddr = kmap_local_folio(folio, off);
+        eol = find_eol(kaddr, seg);
+        kunmap_local(kaddr);
+        folio_put(folio);
+        if (eol)
+            return pos + (eol - kaddr) + 1;
+        pos += seg;
     }
+    return limit;
+}
+
+// Un pedazo de una lectura en paralelo. Empieza y termina en un límite de
+// línea; lo revisa un trabajo en log_watch_par_wq con su propio lw_scan.
+struct lw_segment {
+    struct work_struct work;
+    struct lw_scan s;
+    struct log_file *fw;
+    loff_t start, end;
+    loff_t stop;                    // Hasta dónde quedó revisado
+    int ret;
+    u64 cpu_ns;
+    struct list_head node;          // En ctx->pending, con mensajes por escribir
+};
+
+static void seg_work(struct work_struct *work) {
+    struct lw_segment *seg = container_of(work, struct lw_segment, work);
+    u64 cpu0 = task_sched_runtime(current);
+
+    seg->ret = scan_file_mapped(&seg->s, seg->fw, seg->start, seg->end, &seg->stop);
+    seg->cpu_ns = task_sched_runtime(current) - cpu0;
+}
+
+static void seg_free(struct lw_segment *seg) {
+    kvfree(seg->s.buf);
+    kvfree(seg->s.out);
+    kvfree(seg->s.recs);
+    kfree(seg);
+}
+
+// Los n segmentos de una pasada se reparten LOG_WATCH_PAR_OUT_MAX bytes de
+// mensajes y los registros del anillo, para acotar la memoria de la pasada.
+static struct lw_segment *seg_alloc(struct thread_ctx *ctx, struct log_file *fw, u32 n) {
+    struct lw_segment *seg = kzalloc(sizeof(*seg), GFP_KERNEL);
+
+    if (!seg)
+        return NULL;
+    INIT_WORK(&seg->work, seg_work);
+    seg->fw = fw;
+    seg->s.ctx = ctx;
+    seg->s.buf_size = ctx->scan.buf_size;
+    seg->s.buf = kvmalloc(seg->s.buf_size, GFP_KERNEL);
+    seg->s.out_size = LOG_WATCH_OUT_SIZE;
+    seg->s.out_max = max_t(size_t, LOG_WATCH_OUT_SIZE, LOG_WATCH_PAR_OUT_MAX / n);
+    seg->s.out = ctx->log_file ? kvmalloc(seg->s.out_size, GFP_KERNEL) : NULL;
+    if (ctx->ring) {
+        seg->s.recs_max = max(256u, (ctx->ring->mask + 1) / n);
+        recs_grow(&seg->s);
+    }
+    if (!seg->s.buf || (ctx->log_file && !seg->s.out) || (ctx->ring && !seg->s.recs)) {
+        seg_free(seg);
+        return NULL;
+    }
+    return seg;
+}
+
+// Pasa a ctx->pending los mensajes ya acumulados en ctx->scan.out (de
+// archivos revisados antes en la misma pasada), para que se escriban antes
+// que los de los segmentos que siguen. ctx->scan.out queda con un buffer nuevo.
+static int stash_scan_out(struct thread_ctx *ctx) {
+    struct lw_segment *seg;
+    char *out;
+
+    if (!ctx->scan.out_len)
+        return 0;
+    seg = kzalloc(sizeof(*seg), GFP_KERNEL);
+    out = kvmalloc(ctx->scan.out_size, GFP_KERNEL);
+    if (!seg || !out) {
+        kfree(seg);
+        kvfree(out);
+        return -ENOMEM;
+    }
+    seg->s.out = ctx->scan.out;
+    seg->s.out_len = ctx->scan.out_len;
+    list_add_tail(&seg->node, &ctx->pending);
+    ctx->scan.out = out;
+    ctx->scan.out_len = 0;
     return 0;
 }
 
-// Lee el archivo monitoreado y busca la palabra clave.
-static int monitor_file(struct thread_ctx *ctx, struct log_file *fw) {
-    loff_t size = i_size_read(file_inode(fw->file));
-    char *buffer;
-    ssize_t read_bytes;
+// Revisa en paralelo un archivo con mucho pendiente: lo corta en segmentos
+// alineados a líneas, uno por CPU (de al menos LOG_WATCH_MIN_SEG bytes), y
+// los revisa a la vez sobre el page cache. El primero corre en este mismo
+// trabajo. Los resultados se unen en orden de archivo: los registros pasan
+// al anillo y los mensajes quedan en ctx->pending, detrás de lo que ya
+// tenía ctx->scan.out, y flush_central_log los escribe en ese orden. Si un
+// segmento no termina (mensajes demasiado grandes, falta de memoria, error
+// de lectura), last_pos queda donde se detuvo y lo demás se descarta;
+// monitor_file sigue desde ahí.
+static void scan_parallel(struct thread_ctx *ctx, struct log_file *fw, loff_t size) {
+    loff_t pos = fw->last_pos, backlog = size - pos, next;
+    struct lw_segment *segs[LOG_WATCH_MAX_SEGS];
+    u32 n, i, k;
 
-    if (size <= fw->last_pos) return 0;
+    n = min_t(u64, min_t(u64, num_online_cpus(), div64_u64(backlog, LOG_WATCH_MIN_SEG)),
+              LOG_WATCH_MAX_SEGS);
+    if (n < 2)
+        return;
 
-    buffer = kmalloc(PAGE_SIZE, GFP_KERNEL);
-    if (!buffer) return -ENOMEM;
+    for (i = 0, k = 0; i < n && pos < size; i++) {
+        next = i == n - 1 ? size : next_line(fw, fw->last_pos + div64_u64(backlog * (i + 1), n), size);
+        if (next <= pos)
+            continue;
+        segs[k] = seg_alloc(ctx, fw, n);
+        if (!segs[k])
+            break;
+        segs[k]->start = pos;
+        segs[k]->end = next;
+        pos = next;
+        k++;
+    }
+    if (k < 2 || stash_scan_out(ctx)) {
+        while (k)
+            seg_free(segs[--k]);
+        return;
+    }
 
-    loff_t pos = fw->last_pos;
-    size_t to_read = min_t(size_t, PAGE_SIZE, size - pos);
-    
-    read_bytes = kernel_read(fw->file, buffer, to_read, &pos);
-    if (read_bytes > 0) {
-        if (contains_keyword(buffer, read_bytes, ctx->keyword, ctx->keyword_len)) {
-            write_to_central_log(ctx, fw->path, buffer, read_bytes);
+    for (i = 1; i < k; i++)
+        queue_work(log_watch_par_wq, &segs[i]->work);
+    seg_work(&segs[0]->work);
+    segs[0]->cpu_ns = 0;            // Ya cuenta en el tiempo de este trabajo
+    for (i = 1; i < k; i++)
+        flush_work(&segs[i]->work);
+
+    for (i = 0; i < k; i++) {
+        struct lw_segment *seg = segs[i];
+        struct lw_scan *s = &seg->s;
+        bool done = !seg->ret && seg->stop == seg->end;
+        u32 r;
+
+        for (r = 0; r < s->nrecs; r++)
+            ring_push(ctx->ring, &s->recs[r]);
+        WRITE_ONCE(ctx->scan.bytes_scanned, ctx->scan.bytes_scanned + s->bytes_scanned);
+        WRITE_ONCE(ctx->scan.lines_scanned, ctx->scan.lines_scanned + s->lines_scanned);
+        WRITE_ONCE(ctx->scan.matches, ctx->scan.matches + s->matches);
+        WRITE_ONCE(ctx->cpu_ns, ctx->cpu_ns + seg->cpu_ns);
+        WRITE_ONCE(fw->last_pos, seg->stop);
+
+        if (s->out_len)
+            list_add_tail(&seg->node, &ctx->pending);
+        else
+            seg_free(seg);
+        if (!done) {
+            while (++i < k)
+                seg_free(segs[i]);
+            break;
         }
     }
-    fw->last_pos = pos;
-    
-    kfree(buffer);
+}
+
+// Lee todo lo nuevo del archivo monitoreado y busca la palabra clave, sobre
+// el page cache cuando el archivo lo tiene. Con mucho pendiente, primero se
+// revisa en paralelo.
+static int scan_file(struct thread_ctx *ctx, struct log_file *fw) {
+    struct address_space *mapping = fw->file->f_mapping;
+    u32 par = READ_ONCE(parallel_mb);
+    loff_t size, stop;
+    int ret;
+
+    if (!READ_ONCE(page_cache_scan) || !S_ISREG(fw->inode->i_mode) || IS_DAX(fw->inode) ||
+        !mapping->a_ops->read_folio)
+        return scan_file_read(&ctx->scan, fw);
+
+    size = i_size_read(fw->inode);
+    if (par && size - fw->last_pos >= (loff_t)par << 20)
+        scan_parallel(ctx, fw, size);
+
+    ret = scan_file_mapped(&ctx->scan, fw, fw->last_pos, size, &stop);
+    WRITE_ONCE(fw->last_pos, stop);
+    return ret;
+}
+
+// Revisa un archivo marcado. Si el archivo quedó más corto que lo ya leído
+// se truncó (por ejemplo, una rotación con copytruncate) y se vuelve a leer
+// desde el inicio.
+static int monitor_file(struct thread_ctx *ctx, struct log_file *fw) {
+    loff_t last = fw->last_pos;
+    int ret;
+
+    if (i_size_read(fw->inode) < last) {
+        pr_info_ratelimited("log_watch %u: %s se truncó; se lee desde el inicio\n", ctx->id, fw->path);
+        WRITE_ONCE(fw->last_pos, 0);
+    }
+    ret = scan_file(ctx, fw);
+    if (fw->last_pos != last)
+        WRITE_ONCE(ctx->cursor_dirty, true);
+    return ret;
+}
+
+// Escribe al log central todo lo acumulado: primero ctx->pending (lo que
+// había en ctx->scan.out antes de cada lectura en paralelo y sus segmentos),
+// en orden, y luego ctx->scan.out, que puede tener la continuación del mismo
+// archivo y los archivos siguientes. Solo la llama scan_ctx, que corre en serie
+// por contexto, así que no necesita lock.
+static void flush_central_log(struct thread_ctx *ctx) {
+    struct lw_segment *seg, *tmp;
+
+    list_for_each_entry_safe(seg, tmp, &ctx->pending, node) {
+        write_central_log(ctx, seg->s.out, seg->s.out_len);
+        list_del(&seg->node);
+        seg_free(seg);
+    }
+    if (ctx->scan.out_len) {
+        write_central_log(ctx, ctx->scan.out, ctx->scan.out_len);
+        ctx->scan.out_len = 0;
+    }
+}
+
+// Aviso de fsnotify: el archivo se modificó. Solo marca el archivo y programa
+// la lectura del contexto. Si ya estaba programada no se mueve, así que
+// batch_ms es la latencia máxima desde la primera escritura.
+static int log_watch_event(struct fsnotify_mark *mark, u32 mask, struct inode *inode,
+                           struct inode *dir, const struct qstr *name, u32 cookie) {
+    struct log_mark *lm = container_of(mark, struct log_mark, fsn);
+
+    WRITE_ONCE(lm->fw->dirty, true);
+    queue_delayed_work(log_watch_wq, &lm->ctx->scan_work, msecs_to_jiffies(READ_ONCE(batch_ms)));
+    return 0;
+}
+
+static void log_watch_free_mark(struct fsnotify_mark *mark) {
+    kfree(container_of(mark, struct log_mark, fsn));
+}
+
+static const struct fsnotify_ops log_watch_fsn_ops = {
+    .handle_inode_event = log_watch_event,
+    .free_mark = log_watch_free_mark,
+};
+
+// Coloca la marca de modificación sobre el inodo del archivo
+static int watch_inode(struct thread_ctx *ctx, struct log_file *fw) {
+    struct log_mark *lm;
+    int ret;
+
+    lm = kzalloc(sizeof(*lm), GFP_KERNEL);
+    if (!lm) return -ENOMEM;
+
+    fsnotify_init_mark(&lm->fsn, log_watch_group);
+    lm->fsn.mask = FS_MODIFY;
+    lm->ctx = ctx;
+    lm->fw = fw;
+
+    ret = fsnotify_add_inode_mark(&lm->fsn, file_inode(fw->file), 0);
+    if (ret) {
+        fsnotify_put_mark(&lm->fsn);
+        return ret;
+    }
+    fw->mark = lm;
+    return 0;
+}
+
+// Quita la marca del inodo. Puede quedar un aviso en curso hasta que
+// fsnotify_wait_marks_destroyed() retorne.
+static void unwatch_inode(struct log_file *fw) {
+    if (!fw->mark) return;
+    fsnotify_destroy_mark(&fw->mark->fsn, log_watch_group);
+    fsnotify_put_mark(&fw->mark->fsn);
+    fw->mark = NULL;
+}
+
+// El cursor es texto: una cabecera de largo fijo con el CRC32 y el largo del
+// resto, y una línea "dev inodo posición ruta" por archivo. Se reescribe
+// completo en cada guardado; si quedó a medias (caída durante la escritura)
+// el CRC no coincide y se ignora.
+#define LOG_WATCH_CURSOR_MAGIC "log_watch-cursor 1"
+#define LOG_WATCH_CURSOR_HDR 40         // MAGIC " %08x %011zu\n"
+#define LOG_WATCH_CURSOR_MAX (16 << 20)
+
+static inline u32 inode_dev(struct inode *inode) {
+    return new_encode_dev(inode->i_sb->s_dev);
+}
+
+// Arma en ctx->cursor_snap las posiciones actuales. Se llama con ctx->lock
+// tomado, o con el trabajo del contexto ya cancelado.
+static int cursor_build(struct thread_ctx *ctx) {
+    char hdr[LOG_WATCH_CURSOR_HDR + 1];
+    size_t size = LOG_WATCH_CURSOR_HDR, len = LOG_WATCH_CURSOR_HDR;
+    struct log_file *fw;
+    char *buf;
+
+    list_for_each_entry(fw, &ctx->files, list)
+        size += strlen(fw->path) + 64;
+    buf = kvmalloc(size, GFP_KERNEL);
+    if (!buf)
+        return -ENOMEM;
+
+    list_for_each_entry(fw, &ctx->files, list) {
+        if (strchr(fw->path, '\n'))
+            continue;               // No se puede escribir como una línea
+        len += scnprintf(buf + len, size - len, "%x %llu %lld %s\n", inode_dev(fw->inode),
+                         (u64)fw->inode->i_ino, fw->last_pos, fw->path);
+    }
+    snprintf(hdr, sizeof(hdr), LOG_WATCH_CURSOR_MAGIC " %08x %011zu\n",
+             crc32(0, buf + LOG_WATCH_CURSOR_HDR, len - LOG_WATCH_CURSOR_HDR),
+             len - LOG_WATCH_CURSOR_HDR);
+    memcpy(buf, hdr, LOG_WATCH_CURSOR_HDR);
+
+    kvfree(ctx->cursor_snap);
+    ctx->cursor_snap = buf;
+    ctx->cursor_len = len;
+    WRITE_ONCE(ctx->cursor_dirty, false);
+    return 0;
+}
+
+// Escribe al archivo de cursor lo que armó cursor_build. Se llama sin
+// ctx->lock, desde el trabajo del contexto o al iniciar/detener.
+static void cursor_write(struct thread_ctx *ctx) {
+    struct file *file = ctx->cursor_file;
+    loff_t pos = 0;
+    ssize_t ret;
+
+    ret = kernel_write(file, ctx->cursor_snap, ctx->cursor_len, &pos);
+    if (ret == ctx->cursor_len) {
+        if (i_size_read(file_inode(file)) > pos)
+            ret = vfs_truncate(&file->f_path, pos);
+        if (ret >= 0)
+            ret = vfs_fsync(file, 1);
+    }
+    if (ret < 0)
+        pr_warn_ratelimited("log_watch %u: no se pudo guardar el cursor (%zd)\n", ctx->id, ret);
+
+    kvfree(ctx->cursor_snap);
+    ctx->cursor_snap = NULL;
+    ctx->cursor_next = jiffies + msecs_to_jiffies(READ_ONCE(cursor_sec) * MSEC_PER_SEC);
+}
+
+// Lee el cursor al iniciar. Un cursor vacío es un cursor nuevo; uno dañado
+// se ignora con un aviso y el monitoreo empieza desde el final de los
+// archivos, como sin cursor.
+static int cursor_load(struct thread_ctx *ctx) {
+    loff_t size = i_size_read(file_inode(ctx->cursor_file)), pos = 0;
+    char *buf, *line, *next;
+    unsigned long long ino;
+    long long offset;
+    unsigned int dev, crc;
+    size_t len;
+    u32 n = 0;
+    int k;
+
+    if (!size)
+        return 0;
+    if (size < LOG_WATCH_CURSOR_HDR || size > LOG_WATCH_CURSOR_MAX)
+        goto bad;
+
+    buf = kvmalloc(size + 1, GFP_KERNEL);
+    if (!buf)
+        return -ENOMEM;
+    if (kernel_read(ctx->cursor_file, buf, size, &pos) != size)
+        goto bad_free;
+    buf[size] = '\0';
+    if (sscanf(buf, LOG_WATCH_CURSOR_MAGIC " %x %zu", &crc, &len) != 2 ||
+        len != size - LOG_WATCH_CURSOR_HDR ||
+        crc32(0, buf + LOG_WATCH_CURSOR_HDR, len) != crc)
+        goto bad_free;
+
+    line = buf + LOG_WATCH_CURSOR_HDR;
+    ctx->restore = kvcalloc(count_eol(line, len), sizeof(*ctx->restore), GFP_KERNEL);
+    if (!ctx->restore && len) {
+        kvfree(buf);
+        return -ENOMEM;
+    }
+    for (; (next = strchr(line, '\n')); line = next + 1) {
+        *next = '\0';
+        if (sscanf(line, "%x %llu %lld %n", &dev, &ino, &offset, &k) != 3 || !line[k] || offset < 0)
+            continue;
+        ctx->restore[n++] = (struct lw_cursor){ dev, ino, offset, line + k };
+    }
+    ctx->nrestore = n;
+    ctx->restore_buf = buf;
     return 0;
+
+bad_free:
+    kvfree(buf);
+bad:
+    pr_warn("log_watch: el cursor está dañado; se empieza desde el final de los archivos\n");
+    return 0;
+}
+
+// Posición inicial de un archivo recién agregado: el final actual, o la
+// guardada en el cursor. Si el inodo de la ruta ya no es el del cursor el
+// log rotó y el archivo nuevo se lee completo; si es más corto que la
+// posición guardada se truncó y también se lee desde el inicio.
+static loff_t initial_pos(struct thread_ctx *ctx, struct log_file *fw) {
+    loff_t size = i_size_read(fw->inode);
+    const struct lw_cursor *c = NULL;
+    u32 i;
+
+    for (i = 0; i < ctx->nrestore && !c; i++) {
+        if (!strcmp(ctx->restore[i].path, fw->path))
+            c = &ctx->restore[i];
+    }
+    // La misma ruta puede haberse escrito de otra forma (enlace, ruta relativa)
+    for (i = 0; i < ctx->nrestore && !c; i++) {
+        if (ctx->restore[i].ino == fw->inode->i_ino && ctx->restore[i].dev == inode_dev(fw->inode))
+            c = &ctx->restore[i];
+    }
+    if (!c)
+        return size;
+
+    if (c->ino != fw->inode->i_ino || c->dev != inode_dev(fw->inode)) {
+        pr_info("log_watch: %s rotó desde el último cursor; se lee desde el inicio\n", fw->path);
+        return 0;
+    }
+    if (size < c->offset) {
+        pr_info("log_watch: %s se truncó desde el último cursor; se lee desde el inicio\n", fw->path);
+        return 0;
+    }
+    return c->offset;
+}
+
+// Trabajo de un contexto: lee los archivos que fsnotify marcó. Un aviso que
+// llegue mientras corre vuelve a encolar el trabajo, que correrá después.
+// Las coincidencias se acumulan en ctx->scan.out y se escriben al log central
+// después de soltar ctx->lock. Si el buffer se llena a mitad de un archivo,
+// se vacía y se retoma la pasada. Los lectores del anillo se despiertan
+// junto con cada escritura al log central, no por cada registro.
+// Con cursor, las posiciones se toman al final de la pasada y se guardan
+// después de escribir sus coincidencias, a lo más cada cursor_sec segundos.
+// Si todavía no toca, se programa cursor_work para cuando toque. No se
+// reprograma scan_work con ese retraso: quedaría pendiente y los avisos de
+// fsnotify no podrían adelantarlo a batch_ms.
+static void scan_ctx(struct work_struct *work) {
+    struct thread_ctx *ctx = container_of(to_delayed_work(work), struct thread_ctx, scan_work);
+    u64 t0 = ktime_get_ns(), cpu0 = task_sched_runtime(current);
+    struct log_file *fw;
+    bool full, ckpt = false;
+
+    do {
+        full = false;
+        mutex_lock(&ctx->lock);
+        list_for_each_entry(fw, &ctx->files, list) {
+            if (!xchg(&fw->dirty, false))
+                continue;
+            if (monitor_file(ctx, fw) == -ENOSPC) {
+                WRITE_ONCE(fw->dirty, true);
+                full = true;
+                break;
+            }
+        }
+        if (!full && ctx->cursor_file && ctx->cursor_dirty &&
+            time_after_eq(jiffies, ctx->cursor_next))
+            ckpt = !cursor_build(ctx);
+        mutex_unlock(&ctx->lock);
+
+        flush_central_log(ctx);
+        if (ctx->ring && !ring_empty(ctx->ring))
+            wake_up_interruptible_poll(&ctx->ring->wq, EPOLLIN | EPOLLRDNORM);
+    } while (full);
+
+    if (ckpt)
+        cursor_write(ctx);
+    else if (ctx->cursor_file && READ_ONCE(ctx->cursor_dirty))
+        queue_delayed_work(log_watch_wq, &ctx->cursor_work,
+                           time_after(ctx->cursor_next, jiffies) ? ctx->cursor_next - jiffies : HZ);
+
+    WRITE_ONCE(ctx->scans, ctx->scans + 1);
+    WRITE_ONCE(ctx->last_scan_ns, ktime_get_ns() - t0);
+    WRITE_ONCE(ctx->cpu_ns, ctx->cpu_ns + task_sched_runtime(current) - cpu0);
+}
+
+// Toca guardar el cursor: programa una pasada del contexto, que lo guarda
+// después de escribir las coincidencias de las posiciones que registra.
+// Si ya había una pasada programada se usa esa.
+static void cursor_due(struct work_struct *work) {
+    struct thread_ctx *ctx = container_of(to_delayed_work(work), struct thread_ctx, cursor_work);
+
+    queue_delayed_work(log_watch_wq, &ctx->scan_work, 0);
 }
 
-// Añade un archivo a monitorear al contexto.
-static int add_watched_file(struct thread_ctx *ctx, const char *path) {
+static const struct rhashtable_params log_file_params = {
+    .key_len = sizeof(struct inode *),
+    .key_offset = offsetof(struct log_file, inode),
+    .head_offset = offsetof(struct log_file, node),
+    .automatic_shrinking = true,
+};
+
+static void free_watched_file(struct log_file *fw) {
+    if (fw->file) fput(fw->file);
+    kfree(fw->path);
+    kfree(fw);
+}
+
+// Añade un archivo a monitorear al contexto. El contexto puede estar
+// corriendo, así que la lista y el índice se modifican con ctx->lock.
+// Retorna el índice del archivo en los registros del anillo: idx, o el
+// siguiente libre si idx < 0. Retorna -EEXIST si el archivo ya se monitorea.
+static int add_watched_file(struct thread_ctx *ctx, const char *path, int idx) {
     struct log_file *fw;
     struct file *file;
+    int ret;
     
     file = filp_open(path, O_RDONLY, 0);
     if (IS_ERR(file)) return PTR_ERR(file);
@@ -135,57 +1574,167 @@ static int add_watched_file(struct thread_ctx *ctx, const char *path) {
     }
     
     fw->file = file;
+    fw->inode = file_inode(file);
     fw->path = kstrdup(path, GFP_KERNEL);
     if (!fw->path) {
-        fput(file);
-        kfree(fw);
+        free_watched_file(fw);
         return -ENOMEM;
     }
     
-    fw->last_pos = i_size_read(file_inode(file));
+    fw->last_pos = initial_pos(ctx, fw);
+
+    mutex_lock(&ctx->lock);
+    ret = rhashtable_lookup_insert_fast(&ctx->by_inode, &fw->node, log_file_params);
+    if (ret)
+        goto out_free;
+    ret = watch_inode(ctx, fw);
+    if (ret) {
+        // -EEXIST queda para un archivo que ya está en este contexto, que
+        // start_log_watch ignora; una marca rechazada es un error
+        if (ret == -EEXIST)
+            ret = -EBUSY;
+        rhashtable_remove_fast(&ctx->by_inode, &fw->node, log_file_params);
+        goto out_free;
+    }
+    spin_lock(&ctx->files_lock);
     list_add_tail(&fw->list, &ctx->files);
-    return 0;
+    ctx->nfiles++;
+    spin_unlock(&ctx->files_lock);
+    WRITE_ONCE(ctx->cursor_dirty, true);
+    fw->idx = idx < 0 ? ctx->next_idx : idx;
+    ctx->next_idx = max(ctx->next_idx, fw->idx + 1);
+    mutex_unlock(&ctx->lock);
+    return fw->idx;
+
+out_free:
+    mutex_unlock(&ctx->lock);
+    free_watched_file(fw);
+    return ret;
 }
 
-// Syscall para iniciar el monitoreo.
-SYSCALL_DEFINE3(start_log_watch,
-                const char __user *const __user *, paths,
-                const char __user *, log_path,
-                const char __user *, keyword) {
+// Quita un archivo del contexto. Se busca por el inodo al que apunta path y,
+// si ya no coincide (el log rotó), por la ruta con que se agregó.
+static int remove_watched_file(struct thread_ctx *ctx, const char *path) {
+    struct log_file *fw = NULL, *it;
+    struct inode *inode;
+    struct path p;
     
+    mutex_lock(&ctx->lock);
+    if (!kern_path(path, LOOKUP_FOLLOW, &p)) {
+        inode = d_inode(p.dentry);
+        fw = rhashtable_lookup_fast(&ctx->by_inode, &inode, log_file_params);
+        path_put(&p);
+    }
+    if (!fw) {
+        list_for_each_entry(it, &ctx->files, list) {
+            if (!strcmp(it->path, path)) {
+                fw = it;
+                break;
+            }
+        }
+    }
+    if (!fw) {
+        mutex_unlock(&ctx->lock);
+        return -ENOENT;
+    }
+
+    rhashtable_remove_fast(&ctx->by_inode, &fw->node, log_file_params);
+    spin_lock(&ctx->files_lock);
+    list_del(&fw->list);
+    ctx->nfiles--;
+    spin_unlock(&ctx->files_lock);
+    unwatch_inode(fw);
+    mutex_unlock(&ctx->lock);
+
+    // Un aviso en curso todavía puede marcar fw como modificado
+    fsnotify_wait_marks_destroyed();
+    free_watched_file(fw);
+    return 0;
+}
+
+// Libera un contexto que ya no está en log_watch_ids.
+static void free_ctx(struct thread_ctx *ctx) {
+    struct log_file *fw, *tmp;
+
+    // Primero se quitan todas las marcas y se espera a los avisos en curso,
+    // que todavía pueden tocar ctx y los archivos. Después ya nadie encola
+    // el trabajo y se puede cancelar. cursor_work se deshabilita antes,
+    // porque encola scan_work y scan_work lo vuelve a programar.
+    list_for_each_entry(fw, &ctx->files, list)
+        unwatch_inode(fw);
+    fsnotify_wait_marks_destroyed();
+    disable_delayed_work_sync(&ctx->cursor_work);
+    cancel_delayed_work_sync(&ctx->scan_work);
+
+    // Posiciones finales de un monitoreo que llegó a iniciar
+    if (ctx->cursor_file) {
+        if (ctx->id && !cursor_build(ctx))
+            cursor_write(ctx);
+        fput(ctx->cursor_file);
+    }
+    kvfree(ctx->cursor_snap);
+    kvfree(ctx->restore);
+    kvfree(ctx->restore_buf);
+
+    // Los fd abiertos siguen leyendo lo que quedó en el anillo
+    if (ctx->ring) {
+        WRITE_ONCE(ctx->ring->closed, true);
+        wake_up_interruptible_poll(&ctx->ring->wq, EPOLLIN | EPOLLRDNORM | EPOLLHUP);
+        kref_put(&ctx->ring->ref, ring_free);
+    }
+    if (ctx->log_file) fput(ctx->log_file);
+    kvfree(ctx->scan.buf);
+    kvfree(ctx->scan.out);
+    ac_free(ctx->ac);
+    kfree(ctx->kw);
+    kfree(ctx->keywords);
+
+    list_for_each_entry_safe(fw, tmp, &ctx->files, list) {
+        list_del(&fw->list);
+        free_watched_file(fw);
+    }
+    rhashtable_destroy(&ctx->by_inode);
+
+    kfree(ctx);
+}
+
+static void ctx_release(struct kref *ref) {
+    free_ctx(container_of(ref, struct thread_ctx, ref));
+}
+
+// Inicia el monitoreo; común a start_log_watch y start_log_watch_ex.
+static int do_start_log_watch(const char __user *const __user *paths, const char __user *log_path,
+                              const char __user *keyword, unsigned int flags,
+                              const char __user *cursor_path) {
     struct thread_ctx *ctx;
-    char *k_keyword, *k_log_path;
-    char *k_paths[5] = {0};
-    int i, n_paths = 0;
-    int id, ret = 0;
+    const char __user *user_path;
+    char *k_keyword, *k_log_path, *k_path;
+    int i, ret = 0;
     
+    if (flags & ~(LOG_WATCH_ICASE | LOG_WATCH_FD))
+        return -EINVAL;
+
     // 1. Copia los argumentos del usuario.
-    k_keyword = strndup_user(keyword, 128);
+    k_keyword = strndup_user(keyword, LOG_WATCH_MAX_KEYWORDS);
     if (IS_ERR(k_keyword)) return PTR_ERR(k_keyword);
     
-    k_log_path = strndup_user(log_path, PATH_MAX);
+    // Con LOG_WATCH_FD el log central es opcional
+    if (!log_path && (flags & LOG_WATCH_FD))
+        k_log_path = NULL;
+    else
+        k_log_path = strndup_user(log_path, PATH_MAX);
     if (IS_ERR(k_log_path)) {
         ret = PTR_ERR(k_log_path);
         goto out_keyword;
     }
     
-    for (n_paths = 0; n_paths < 5; n_paths++) {
-        const char __user *user_path;
-        if (copy_from_user(&user_path, &paths[n_paths], sizeof(user_path))) {
-            ret = -EFAULT;
-            goto out_paths;
-        }
-        if (!user_path) break;
-        
-        k_paths[n_paths] = strndup_user(user_path, PATH_MAX);
-        if (IS_ERR(k_paths[n_paths])) {
-            ret = PTR_ERR(k_paths[n_paths]);
-            k_paths[n_paths] = NULL;
-            goto out_paths;
-        }
+    // Las rutas se copian una por una al agregarlas; aquí solo se verifica
+    // que haya al menos una
+    if (get_user(user_path, &paths[0])) {
+        ret = -EFAULT;
+        goto out_paths;
     }
-    
-    if (n_paths == 0) {
+    if (!user_path) {
         ret = -EINVAL;
         goto out_paths;
     }
@@ -196,106 +1745,354 @@ SYSCALL_DEFINE3(start_log_watch,
         ret = -ENOMEM;
         goto out_paths;
     }
+    ret = rhashtable_init(&ctx->by_inode, &log_file_params);
+    if (ret) {
+        kfree(ctx);
+        goto out_paths;
+    }
     
+    kref_init(&ctx->ref);
     INIT_LIST_HEAD(&ctx->files);
+    INIT_LIST_HEAD(&ctx->pending);
     mutex_init(&ctx->lock);
-    init_waitqueue_head(&ctx->waitq);
-    strscpy(ctx->keyword, k_keyword, 128);
-    ctx->keyword_len = strlen(ctx->keyword);
-    
-    ctx->log_file = filp_open(k_log_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
-    if (IS_ERR(ctx->log_file)) {
-        ret = PTR_ERR(ctx->log_file);
-        ctx->log_file = NULL;
+    spin_lock_init(&ctx->files_lock);
+    INIT_DELAYED_WORK(&ctx->scan_work, scan_ctx);
+    INIT_DELAYED_WORK(&ctx->cursor_work, cursor_due);
+    ctx->keywords = k_keyword;
+    k_keyword = NULL;
+    ret = compile_keywords(ctx, flags & LOG_WATCH_ICASE);
+    if (ret)
+        goto out_ctx;
+
+    ctx->scan.ctx = ctx;
+    ctx->scan.buf_size = (size_t)max_t(unsigned int, READ_ONCE(buf_kb), LOG_WATCH_MIN_BUF_KB) * 1024;
+    ctx->scan.buf = kvmalloc(ctx->scan.buf_size, GFP_KERNEL);
+    ctx->scan.out_size = ctx->scan.out_max = LOG_WATCH_OUT_SIZE;
+    ctx->scan.out = kvmalloc(LOG_WATCH_OUT_SIZE, GFP_KERNEL);
+    if (!ctx->scan.buf || !ctx->scan.out) {
+        ret = -ENOMEM;
         goto out_ctx;
     }
     
-    for (i = 0; i < n_paths; i++) {
-        ret = add_watched_file(ctx, k_paths[i]);
-        if (ret) goto out_ctx;
+    if (flags & LOG_WATCH_FD) {
+        ctx->ring = ring_alloc();
+        if (!ctx->ring) {
+            ret = -ENOMEM;
+            goto out_ctx;
+        }
+    }
+
+    if (k_log_path) {
+        ctx->log_file = filp_open(k_log_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (IS_ERR(ctx->log_file)) {
+            ret = PTR_ERR(ctx->log_file);
+            ctx->log_file = NULL;
+            goto out_ctx;
+        }
     }
-    
-    // 3. Asigna un ID único y lo guarda
-    ctx->id = atomic_fetch_add(1, &id_counter);
 
-    mutex_lock(&context_list_lock);
-    list_add_tail(&ctx->list, &context_list);
-    mutex_unlock(&context_list_lock);
+    // Posiciones guardadas por un monitoreo anterior con el mismo cursor
+    if (cursor_path) {
+        k_path = strndup_user(cursor_path, PATH_MAX);
+        if (IS_ERR(k_path)) {
+            ret = PTR_ERR(k_path);
+            goto out_ctx;
+        }
+        ctx->cursor_file = filp_open(k_path, O_RDWR | O_CREAT, 0600);
+        kfree(k_path);
+        if (IS_ERR(ctx->cursor_file)) {
+            ret = PTR_ERR(ctx->cursor_file);
+            ctx->cursor_file = NULL;
+            goto out_ctx;
+        }
+        ret = cursor_load(ctx);
+        if (ret)
+            goto out_ctx;
+    }
     
-    if (id < 0) {
-        ret = id;
-        goto out_ctx;
+    // Lista de archivos terminada en NULL, sin límite de cantidad. Un
+    // archivo repetido se monitorea una sola vez. El índice de cada archivo
+    // en los registros del anillo es su posición en paths.
+    for (i = 0; ; i++) {
+        if (get_user(user_path, &paths[i])) {
+            ret = -EFAULT;
+            goto out_ctx;
+        }
+        if (!user_path) break;
+
+        k_path = strndup_user(user_path, PATH_MAX);
+        if (IS_ERR(k_path)) {
+            ret = PTR_ERR(k_path);
+            goto out_ctx;
+        }
+        // Solo se ignora una ruta repetida en la lista (mismo inodo en este
+        // contexto); cualquier otro error detiene el inicio
+        ret = add_watched_file(ctx, k_path, i);
+        kfree(k_path);
+        if (ret < 0 && ret != -EEXIST) goto out_ctx;
+
+        if (fatal_signal_pending(current)) {
+            ret = -EINTR;
+            goto out_ctx;
+        }
+        cond_resched();
     }
-    ctx->id = id;
     
-    // 4. Lanza el hilo del kernel.
-    ctx->thread = kthread_run(monitor_thread, ctx, "log_watch_%u", id);
-    if (IS_ERR(ctx->thread)) {
-        ret = PTR_ERR(ctx->thread);
-        mutex_lock(&context_list_lock);
-        list_del(&ctx->list);
-        mutex_unlock(&context_list_lock);
-        goto out_ctx;
+    // Las posiciones del cursor solo se usan al agregar los archivos
+    // iniciales. El primer guardado lo hace el trabajo del contexto, que es
+    // quien escribe el cursor mientras el monitoreo corre.
+    if (ctx->cursor_file) {
+        kvfree(ctx->restore);
+        kvfree(ctx->restore_buf);
+        ctx->restore = NULL;
+        ctx->restore_buf = NULL;
+        ctx->nrestore = 0;
+        ctx->cursor_next = jiffies;
+        queue_delayed_work(log_watch_wq, &ctx->scan_work, 0);
     }
+
+    // 3. Registra el contexto con un ID único. Los IDs avanzan de forma
+    // cíclica, así que un ID recién liberado no se reutiliza de inmediato.
+    // Las lecturas corren en log_watch_wq.
+    mutex_lock(&registry_lock);
+    ret = xa_alloc_cyclic(&log_watch_ids, &ctx->id, ctx, xa_limit_31b, &next_id, GFP_KERNEL);
+    mutex_unlock(&registry_lock);
+    if (ret < 0)
+        goto out_ctx;
+    ret = ctx->id;
     
-    // 5. Libera la memoria temporal y retorna el ID.
+    // 4. Libera la memoria temporal y retorna el ID.
 out_paths:
-    for (i = 0; i < n_paths; i++) kfree(k_paths[i]);
     kfree(k_log_path);
 out_keyword:
     kfree(k_keyword);
     
-    return ctx->id;
+    return ret;
 
 out_ctx:
-    struct log_file *fw, *tmp;
-    
-    if (ctx->log_file) fput(ctx->log_file);
-    
-    list_for_each_entry_safe(fw, tmp, &ctx->files, list) {
-        list_del(&fw->list);
-        if (fw->file) fput(fw->file);
-        kfree(fw->path);
-        kfree(fw);
-    }
-    
-    kfree(ctx);
+    free_ctx(ctx);
     goto out_paths;
 }
 
+// Syscall para iniciar el monitoreo.
+SYSCALL_DEFINE3(start_log_watch,
+                const char __user *const __user *, paths,
+                const char __user *, log_path,
+                const char __user *, keyword) {
+    return do_start_log_watch(paths, log_path, keyword, 0, NULL);
+}
+
+// Igual que start_log_watch, con opciones LOG_WATCH_* en flags.
+SYSCALL_DEFINE4(start_log_watch_ex,
+                const char __user *const __user *, paths,
+                const char __user *, log_path,
+                const char __user *, keyword,
+                unsigned int, flags) {
+    return do_start_log_watch(paths, log_path, keyword, flags, NULL);
+}
+
+// Igual que start_log_watch_ex, guardando la posición de cada archivo en
+// cursor_path. Si el cursor ya existe, cada archivo continúa desde donde lo
+// dejó el monitoreo anterior en lugar de empezar en su final.
+SYSCALL_DEFINE5(start_log_watch_cursor,
+                const char __user *const __user *, paths,
+                const char __user *, log_path,
+                const char __user *, keyword,
+                unsigned int, flags,
+                const char __user *, cursor_path) {
+    if (!cursor_path)
+        return -EINVAL;
+    return do_start_log_watch(paths, log_path, keyword, flags, cursor_path);
+}
+
+// Busca un contexto por ID. Se llama con registry_lock tomado.
+static struct thread_ctx *find_ctx(u32 id) {
+    return xa_load(&log_watch_ids, id);
+}
+
+// Agrega o quita un archivo de un monitoreo existente. Abrir el archivo y
+// esperar a que fsnotify suelte la marca pueden tardar, así que no se hace
+// con registry_lock: una referencia evita que stop_log_watch libere el
+// contexto a la vez, y el resto lo protege ctx->lock.
+static int change_watched_file(u32 id, const char __user *path, bool add) {
+    struct thread_ctx *ctx;
+    char *k_path;
+    int ret;
+
+    k_path = strndup_user(path, PATH_MAX);
+    if (IS_ERR(k_path)) return PTR_ERR(k_path);
+
+    mutex_lock(&registry_lock);
+    ctx = find_ctx(id);
+    if (ctx)
+        kref_get(&ctx->ref);
+    mutex_unlock(&registry_lock);
+
+    if (!ctx)
+        ret = -ESRCH;
+    else if (add)
+        ret = add_watched_file(ctx, k_path, -1);
+    else
+        ret = remove_watched_file(ctx, k_path);
+    if (ctx)
+        kref_put(&ctx->ref, ctx_release);
+
+    kfree(k_path);
+    return ret;
+}
+
+// Syscall para agregar un archivo a un monitoreo en curso. Se empieza a leer
+// desde el final actual del archivo. Retorna su índice en los registros.
+SYSCALL_DEFINE2(log_watch_add_file, u32, id, const char __user *, path) {
+    return change_watched_file(id, path, true);
+}
+
+// Syscall para dejar de monitorear un archivo sin detener el monitoreo.
+SYSCALL_DEFINE2(log_watch_remove_file, u32, id, const char __user *, path) {
+    return change_watched_file(id, path, false);
+}
+
 // Syscall para detener el monitoreo por ID.
 SYSCALL_DEFINE1(stop_log_watch, u32, id) {
     struct thread_ctx *ctx;
     
     // 1. Busca el contexto usando el ID.
-    mutex_lock(&context_list_lock);
-    list_for_each_entry(ctx, &context_list, list) {
-        if (ctx->id == id)
-            break;
-    }
-    if (&ctx->list == &context_list) {
-        mutex_unlock(&context_list_lock);
-        return -ESRCH;
-    }
+    mutex_lock(&registry_lock);
+    ctx = find_ctx(id);
     if (!ctx) {
-        mutex_unlock(&context_list_lock);
+        mutex_unlock(&registry_lock);
         return -ESRCH; // Retorna si el ID no existe.
     }
     
-    // 2. Si ya está detenido, retorna un error.
-    if (READ_ONCE(ctx->stop)) {
-        mutex_unlock(&context_list_lock);
-        return -EALREADY;
-    }
-    
-    // 3. Marca la bandera de detención y remueve el ID.
-    WRITE_ONCE(ctx->stop, true);
-    list_del(&ctx->list);
-    mutex_unlock(&context_list_lock);
+    // 2. Remueve el ID; una segunda llamada ya no lo encuentra.
+    xa_erase(&log_watch_ids, id);
+    mutex_unlock(&registry_lock);
     
-    // 4. Despierta el hilo para que se detenga y libera los recursos.
-    wake_up_interruptible(&ctx->waitq);
-    if (ctx->thread) kthread_stop(ctx->thread);
+    // 3. Suelta la referencia del registro. Quien suelte la última espera
+    // la lectura en curso, si hay, y libera los recursos.
+    kref_put(&ctx->ref, ctx_release);
     
     return 0;
-}
\ No newline at end of file
+}
+
+// Llena las estadísticas de un contexto. Se llama con registry_lock tomado,
+// así que el contexto no se libera. La lista de archivos se recorre con
+// files_lock y no con ctx->lock, para no esperar a una pasada larga, que es
+// justo lo que se quiere observar.
+static void fill_info(struct thread_ctx *ctx, struct log_watch_info *info) {
+    struct log_file *fw;
+    loff_t size, pos;
+
+    memset(info, 0, sizeof(*info));
+    info->id = ctx->id;
+    info->bytes_scanned = READ_ONCE(ctx->scan.bytes_scanned);
+    info->lines_scanned = READ_ONCE(ctx->scan.lines_scanned);
+    info->matches = READ_ONCE(ctx->scan.matches);
+    info->scans = READ_ONCE(ctx->scans);
+    info->last_scan_ns = READ_ONCE(ctx->last_scan_ns);
+    info->cpu_ns = READ_ONCE(ctx->cpu_ns);
+    if (ctx->ring)
+        info->dropped = READ_ONCE(ctx->ring->dropped);
+
+    spin_lock(&ctx->files_lock);
+    info->nfiles = ctx->nfiles;
+    list_for_each_entry(fw, &ctx->files, list) {
+        size = i_size_read(fw->inode);
+        pos = READ_ONCE(fw->last_pos);
+        if (size > pos)
+            info->backlog += size - pos;
+    }
+    spin_unlock(&ctx->files_lock);
+}
+
+// Syscall para consultar las estadísticas de los monitoreos. Con id != 0
+// llena info con ese monitoreo y retorna 1. Con id == 0 llena hasta count
+// entradas, en orden de ID, y retorna cuántos monitoreos hay en total
+// (count == 0 solo los cuenta).
+SYSCALL_DEFINE3(log_watch_query, u32, id, struct log_watch_info __user *, info, u32, count) {
+    struct log_watch_info k_info;
+    struct thread_ctx *ctx;
+    unsigned long i;
+    long n = 0;
+
+    mutex_lock(&registry_lock);
+    if (id) {
+        ctx = find_ctx(id);
+        if (!ctx) {
+            n = -ESRCH;
+        } else if (!count) {
+            n = -EINVAL;
+        } else {
+            fill_info(ctx, &k_info);
+            n = copy_to_user(info, &k_info, sizeof(k_info)) ? -EFAULT : 1;
+        }
+        mutex_unlock(&registry_lock);
+        return n;
+    }
+
+    xa_for_each(&log_watch_ids, i, ctx) {
+        if (n < count) {
+            fill_info(ctx, &k_info);
+            if (copy_to_user(info + n, &k_info, sizeof(k_info))) {
+                n = -EFAULT;
+                break;
+            }
+        }
+        n++;
+    }
+    mutex_unlock(&registry_lock);
+    return n;
+}
+
+// Syscall para abrir el anillo de coincidencias de un monitoreo iniciado con
+// LOG_WATCH_FD. El fd entrega struct log_watch_rec con read y avisa con poll.
+// flags admite O_NONBLOCK y O_CLOEXEC. Varios fd del mismo monitoreo
+// comparten el anillo: cada registro lo recibe uno solo.
+SYSCALL_DEFINE2(log_watch_open, u32, id, int, flags) {
+    struct thread_ctx *ctx;
+    struct lw_ring *ring;
+    int fd;
+
+    if (flags & ~(O_NONBLOCK | O_CLOEXEC))
+        return -EINVAL;
+
+    mutex_lock(&registry_lock);
+    ctx = find_ctx(id);
+    if (!ctx) {
+        mutex_unlock(&registry_lock);
+        return -ESRCH;
+    }
+    ring = ctx->ring;
+    if (ring)
+        kref_get(&ring->ref);
+    mutex_unlock(&registry_lock);
+    if (!ring)
+        return -EINVAL;
+
+    fd = anon_inode_getfd("[log_watch]", &log_watch_ring_fops, ring, O_RDONLY | flags);
+    if (fd < 0)
+        kref_put(&ring->ref, ring_free);
+    return fd;
+}
+
+static int __init log_watch_init(void) {
+    // Sin CPU fija: una pasada larga revisando un atraso grande ocupa la CPU
+    // por mucho tiempo y no debe retener el pool de workers compartido de una CPU
+    log_watch_wq = alloc_workqueue("log_watch", WQ_UNBOUND, 0);
+    if (!log_watch_wq)
+        return -ENOMEM;
+    log_watch_par_wq = alloc_workqueue("log_watch_par", WQ_UNBOUND, 0);
+    if (!log_watch_par_wq) {
+        destroy_workqueue(log_watch_wq);
+        return -ENOMEM;
+    }
+
+    log_watch_group = fsnotify_alloc_group(&log_watch_fsn_ops, FSNOTIFY_GROUP_DUPS);
+    if (IS_ERR(log_watch_group)) {
+        destroy_workqueue(log_watch_par_wq);
+        destroy_workqueue(log_watch_wq);
+        return PTR_ERR(log_watch_group);
+    }
+    return 0;
+}
+late_initcall(log_watch_init);
\ No newline at end of file
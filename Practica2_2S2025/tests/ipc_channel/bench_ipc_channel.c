@@ -0,0 +1,717 @@
+// Benchmark de ipc_channel contra pipes, colas POSIX (mq_send) y un anillo
+// en espacio de usuario con futex.
+//
+// Modos:
+//   pingpong    latencia de ida y vuelta (p50/p99/p999) entre dos hilos
+//   throughput  N productores / M consumidores sobre una sola cola
+//   sweep       pingpong y throughput para varios tamaños de mensaje
+//
+// Uso:
+//   bench_ipc_channel [-m modo] [-t transporte] [-n mensajes] [-s tamaño]
+//                     [-d profundidad] [-p productores] [-c consumidores]
+//                     [-a cpu,cpu,...] [-f csv|json]
+//
+// Transportes: ipc, ipc-shm, pipe, mq, futex o all (por defecto).
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <pthread.h>
+#include <mqueue.h>
+#include <limits.h>
+#include <linux/futex.h>
+
+#include "ipc_shm_ring.h"
+
+#define SYS_IPC_CHANNEL_SENDV 471
+#define SYS_IPC_CHANNEL_RECVV 472
+#define SYS_IPC_CHANNEL_CREATE 473
+#define SYS_IPC_CHANNEL_CLOSE 475
+
+#define MIN_SIZE 8                      // Los primeros 4 bytes llevan el número de mensaje
+#define SENTINEL 0xffffffffu            // Indica a un consumidor que termine
+#define MAX_THREADS 64
+#define MAX_CPUS 256
+
+struct ipc_msg_vec {
+    uint64_t data_pointer;
+    uint32_t len;
+    uint32_t prio;
+};
+
+// Anillo MPMC en espacio de usuario, mismo algoritmo que ipc_shm_ring.h
+// pero durmiendo con futex(2) privado. Es la referencia de "sin kernel".
+struct fring {
+    uint32_t depth;
+    uint32_t slot_size;
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    uint32_t data_seq __attribute__((aligned(64)));
+    uint32_t data_waiters;
+    uint32_t space_seq __attribute__((aligned(64)));
+    uint32_t space_waiters;
+    char *slots;
+};
+
+struct chan {
+    int fd;
+    int fds[2];
+    mqd_t mq;
+    struct ipc_shm_ring shm;
+    struct fring *fr;
+    char name[64];
+    size_t size;
+};
+
+struct transport {
+    const char *name;
+    int (*open)(struct chan *c, size_t size, unsigned depth);
+    int (*send)(struct chan *c, const void *buf, size_t len);
+    int (*recv)(struct chan *c, void *buf, size_t len);
+    void (*close)(struct chan *c);
+};
+
+struct result {
+    const char *modo;
+    const char *transporte;
+    size_t tamano;
+    int productores;
+    int consumidores;
+    long mensajes;
+    double segundos;
+    double p50, p99, p999;      // ns, solo en pingpong
+};
+
+static int cpus[MAX_CPUS];
+static int ncpus;
+static int json;
+static int filas;
+static int canales;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Fija el hilo actual a la CPU que le toca según la lista -a
+static void pin_thread(int idx) {
+    cpu_set_t set;
+
+    if (ncpus == 0)
+        return;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[idx % ncpus], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void unique_name(struct chan *c, const char *prefix) {
+    snprintf(c->name, sizeof(c->name), "%sbench_%d_%d", prefix, getpid(), canales++);
+}
+
+// ---- ipc_channel con sendv/recvv ----
+
+static int ipc_open(struct chan *c, size_t size, unsigned depth) {
+    unique_name(c, "");
+    c->size = size;
+    c->fd = syscall(SYS_IPC_CHANNEL_CREATE, c->name, depth, size, 0);
+    return c->fd < 0 ? -errno : 0;
+}
+
+static int ipc_send(struct chan *c, const void *buf, size_t len) {
+    struct ipc_msg_vec vec = { (uintptr_t)buf, len, 0 };
+    return syscall(SYS_IPC_CHANNEL_SENDV, c->fd, &vec, 1) == 1 ? 0 : -errno;
+}
+
+static int ipc_recv(struct chan *c, void *buf, size_t len) {
+    struct ipc_msg_vec vec = { (uintptr_t)buf, len, 0 };
+    return syscall(SYS_IPC_CHANNEL_RECVV, c->fd, &vec, 1) == 1 ? 0 : -errno;
+}
+
+static void ipc_close(struct chan *c) {
+    syscall(SYS_IPC_CHANNEL_CLOSE, c->fd);
+    close(c->fd);
+}
+
+// ---- ipc_channel en memoria compartida ----
+
+static int shm_open_chan(struct chan *c, size_t size, unsigned depth) {
+    int ret;
+
+    unique_name(c, "");
+    c->size = size;
+    c->fd = syscall(SYS_IPC_CHANNEL_CREATE, c->name, depth, size, IPC_CHANNEL_SHM);
+    if (c->fd < 0)
+        return -errno;
+    ret = shm_ring_map(&c->shm, c->fd);
+    if (ret) {
+        ipc_close(c);
+        return ret;
+    }
+    return 0;
+}
+
+static int shm_send(struct chan *c, const void *buf, size_t len) {
+    int ret = shm_ring_push(&c->shm, buf, len);
+    return ret < 0 ? ret : 0;
+}
+
+static int shm_recv(struct chan *c, void *buf, size_t len) {
+    int ret = shm_ring_pop(&c->shm, buf, len);
+    return ret < 0 ? ret : 0;
+}
+
+static void shm_close_chan(struct chan *c) {
+    shm_ring_unmap(&c->shm);
+    ipc_close(c);
+}
+
+// ---- pipe ----
+
+static int pipe_open(struct chan *c, size_t size, unsigned depth) {
+    if (pipe(c->fds) < 0)
+        return -errno;
+    c->size = size;
+    // Capacidad parecida a la de las otras colas (el kernel redondea a páginas)
+    fcntl(c->fds[1], F_SETPIPE_SZ, (int)(size * depth));
+    return 0;
+}
+
+static int pipe_send(struct chan *c, const void *buf, size_t len) {
+    const char *p = buf;
+    ssize_t n;
+
+    while (len) {
+        n = write(c->fds[1], p, len);
+        if (n < 0)
+            return -errno;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int pipe_recv(struct chan *c, void *buf, size_t len) {
+    char *p = buf;
+    ssize_t n;
+
+    while (len) {
+        n = read(c->fds[0], p, len);
+        if (n <= 0)
+            return n < 0 ? -errno : -EPIPE;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void pipe_close(struct chan *c) {
+    close(c->fds[0]);
+    close(c->fds[1]);
+}
+
+// ---- colas POSIX ----
+
+static int mq_open_chan(struct chan *c, size_t size, unsigned depth) {
+    struct mq_attr attr = { .mq_maxmsg = depth, .mq_msgsize = size };
+
+    unique_name(c, "/");
+    c->size = size;
+    c->mq = mq_open(c->name, O_CREAT | O_EXCL | O_RDWR, 0600, &attr);
+    if (c->mq == (mqd_t)-1 && errno == EINVAL) {
+        // /proc/sys/fs/mqueue/msg_max suele limitar la profundidad a 10
+        attr.mq_maxmsg = 10;
+        c->mq = mq_open(c->name, O_CREAT | O_EXCL | O_RDWR, 0600, &attr);
+    }
+    return c->mq == (mqd_t)-1 ? -errno : 0;
+}
+
+static int mq_send_chan(struct chan *c, const void *buf, size_t len) {
+    return mq_send(c->mq, buf, len, 0) < 0 ? -errno : 0;
+}
+
+static int mq_recv_chan(struct chan *c, void *buf, size_t len) {
+    (void)len;
+    return mq_receive(c->mq, buf, c->size, NULL) < 0 ? -errno : 0;
+}
+
+static void mq_close_chan(struct chan *c) {
+    mq_close(c->mq);
+    mq_unlink(c->name);
+}
+
+// ---- anillo con futex ----
+
+static long futex(uint32_t *addr, int op, uint32_t val) {
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+static int fring_open(struct chan *c, size_t size, unsigned depth) {
+    struct fring *r;
+    unsigned d = 1;
+
+    while (d < depth)
+        d <<= 1;
+
+    if (posix_memalign((void **)&r, 64, sizeof(*r)))
+        return -ENOMEM;
+    memset(r, 0, sizeof(*r));
+    r->depth = d;
+    r->slot_size = (sizeof(struct ipc_shm_slot) + size + 63) & ~63u;
+    if (posix_memalign((void **)&r->slots, 64, (size_t)d * r->slot_size)) {
+        free(r);
+        return -ENOMEM;
+    }
+    for (unsigned i = 0; i < d; i++)
+        ((struct ipc_shm_slot *)(r->slots + (size_t)i * r->slot_size))->seq = i;
+
+    c->fr = r;
+    c->size = size;
+    return 0;
+}
+
+static inline struct ipc_shm_slot *fring_slot(struct fring *r, uint64_t pos) {
+    return (struct ipc_shm_slot *)(r->slots + (pos & (r->depth - 1)) * r->slot_size);
+}
+
+static int fring_send(struct chan *c, const void *buf, size_t len) {
+    struct fring *r = c->fr;
+    struct ipc_shm_slot *s;
+    uint64_t pos;
+    uint32_t seq;
+
+    for (;;) {
+        pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+        for (;;) {
+            s = fring_slot(r, pos);
+            int64_t dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - pos);
+            if (dif == 0) {
+                if (__atomic_compare_exchange_n(&r->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    goto claimed;
+            } else if (dif < 0) {
+                break;
+            } else {
+                pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+            }
+        }
+
+        // Lleno: dormir hasta que un consumidor libere una casilla
+        seq = __atomic_load_n(&r->space_seq, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&r->space_waiters, 1, __ATOMIC_SEQ_CST);
+        pos = __atomic_load_n(&r->head, __ATOMIC_SEQ_CST);
+        if ((int64_t)(__atomic_load_n(&fring_slot(r, pos)->seq, __ATOMIC_SEQ_CST) - pos) < 0)
+            futex(&r->space_seq, FUTEX_WAIT_PRIVATE, seq);
+        __atomic_fetch_sub(&r->space_waiters, 1, __ATOMIC_SEQ_CST);
+    }
+
+claimed:
+    memcpy(s->dat, buf, len);
+    s->len = len;
+    __atomic_store_n(&s->seq, pos + 1, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&r->data_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->data_waiters, __ATOMIC_SEQ_CST))
+        futex(&r->data_seq, FUTEX_WAKE_PRIVATE, INT_MAX);
+    return 0;
+}
+
+static int fring_recv(struct chan *c, void *buf, size_t len) {
+    struct fring *r = c->fr;
+    struct ipc_shm_slot *s;
+    uint64_t pos;
+    uint32_t seq;
+
+    for (;;) {
+        pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+        for (;;) {
+            s = fring_slot(r, pos);
+            int64_t dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+            if (dif == 0) {
+                if (__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    goto claimed;
+            } else if (dif < 0) {
+                break;
+            } else {
+                pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+            }
+        }
+
+        // Vacío: dormir hasta que un productor publique
+        seq = __atomic_load_n(&r->data_seq, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&r->data_waiters, 1, __ATOMIC_SEQ_CST);
+        pos = __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST);
+        if ((int64_t)(__atomic_load_n(&fring_slot(r, pos)->seq, __ATOMIC_SEQ_CST) - (pos + 1)) < 0)
+            futex(&r->data_seq, FUTEX_WAIT_PRIVATE, seq);
+        __atomic_fetch_sub(&r->data_waiters, 1, __ATOMIC_SEQ_CST);
+    }
+
+claimed:
+    memcpy(buf, s->dat, len < s->len ? len : s->len);
+    __atomic_store_n(&s->seq, pos + r->depth, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&r->space_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->space_waiters, __ATOMIC_SEQ_CST))
+        futex(&r->space_seq, FUTEX_WAKE_PRIVATE, INT_MAX);
+    return 0;
+}
+
+static void fring_close(struct chan *c) {
+    free(c->fr->slots);
+    free(c->fr);
+}
+
+static const struct transport transports[] = {
+    { "ipc", ipc_open, ipc_send, ipc_recv, ipc_close },
+    { "ipc-shm", shm_open_chan, shm_send, shm_recv, shm_close_chan },
+    { "pipe", pipe_open, pipe_send, pipe_recv, pipe_close },
+    { "mq", mq_open_chan, mq_send_chan, mq_recv_chan, mq_close_chan },
+    { "futex", fring_open, fring_send, fring_recv, fring_close },
+};
+
+// ---- salida ----
+
+static void print_result(const struct result *r) {
+    double msgs_s = r->mensajes / r->segundos;
+    double mb_s = msgs_s * r->tamano / 1e6;
+
+    if (json) {
+        printf("%s  {\"modo\": \"%s\", \"transporte\": \"%s\", \"tamano\": %zu, "
+               "\"productores\": %d, \"consumidores\": %d, \"mensajes\": %ld, "
+               "\"segundos\": %.6f, \"msgs_s\": %.0f, \"mb_s\": %.2f",
+               filas ? ",\n" : "", r->modo, r->transporte, r->tamano, r->productores,
+               r->consumidores, r->mensajes, r->segundos, msgs_s, mb_s);
+        if (r->p50 > 0)
+            printf(", \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f", r->p50, r->p99, r->p999);
+        printf("}");
+    } else {
+        if (!filas)
+            printf("modo,transporte,tamano,productores,consumidores,mensajes,segundos,msgs_s,mb_s,p50_ns,p99_ns,p999_ns\n");
+        printf("%s,%s,%zu,%d,%d,%ld,%.6f,%.0f,%.2f,", r->modo, r->transporte, r->tamano,
+               r->productores, r->consumidores, r->mensajes, r->segundos, msgs_s, mb_s);
+        if (r->p50 > 0)
+            printf("%.0f,%.0f,%.0f\n", r->p50, r->p99, r->p999);
+        else
+            printf(",,\n");
+    }
+    fflush(stdout);
+    filas++;
+}
+
+// ---- ping-pong ----
+
+struct pingpong {
+    const struct transport *t;
+    struct chan req, resp;
+    size_t size;
+    long total;                 // Incluye el calentamiento
+    long warmup;
+    uint64_t *lat;
+    int err;
+};
+
+static void *pingpong_server(void *arg) {
+    struct pingpong *pp = arg;
+    char *buf = calloc(1, pp->size);
+    int ret = 0;
+
+    pin_thread(1);
+    for (long i = 0; i < pp->total && !ret; i++) {
+        ret = pp->t->recv(&pp->req, buf, pp->size);
+        if (!ret)
+            ret = pp->t->send(&pp->resp, buf, pp->size);
+    }
+    free(buf);
+    return NULL;
+}
+
+static void *pingpong_client(void *arg) {
+    struct pingpong *pp = arg;
+    char *buf = calloc(1, pp->size);
+    uint64_t t0;
+    int ret;
+
+    pin_thread(0);
+    for (long i = 0; i < pp->total; i++) {
+        memcpy(buf, &i, sizeof(uint32_t));
+        t0 = now_ns();
+        ret = pp->t->send(&pp->req, buf, pp->size);
+        if (!ret)
+            ret = pp->t->recv(&pp->resp, buf, pp->size);
+        if (ret) {
+            pp->err = -ret;
+            break;
+        }
+        if (i >= pp->warmup)
+            pp->lat[i - pp->warmup] = now_ns() - t0;
+    }
+    free(buf);
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int run_pingpong(const struct transport *t, size_t size, unsigned depth, long n) {
+    struct pingpong pp = { .t = t, .size = size };
+    struct result r = { "pingpong", t->name, size, 1, 1, n, 0, 0, 0, 0 };
+    pthread_t cli, srv;
+    uint64_t t0, t1;
+    int ret;
+
+    pp.warmup = n / 10 < 1000 ? n / 10 : 1000;
+    pp.total = n + pp.warmup;
+    pp.lat = malloc(n * sizeof(*pp.lat));
+    if (!pp.lat)
+        return -ENOMEM;
+
+    ret = t->open(&pp.req, size, depth);
+    if (ret)
+        goto out;
+    ret = t->open(&pp.resp, size, depth);
+    if (ret) {
+        t->close(&pp.req);
+        goto out;
+    }
+
+    t0 = now_ns();
+    pthread_create(&srv, NULL, pingpong_server, &pp);
+    pthread_create(&cli, NULL, pingpong_client, &pp);
+    pthread_join(cli, NULL);
+    t1 = now_ns();
+    if (pp.err) {
+        // El servidor puede quedar bloqueado esperando una solicitud que no llegará
+        pthread_cancel(srv);
+    }
+    pthread_join(srv, NULL);
+    t->close(&pp.req);
+    t->close(&pp.resp);
+
+    if (pp.err) {
+        ret = -pp.err;
+        goto out;
+    }
+
+    // Percentiles del tiempo de ida y vuelta
+    qsort(pp.lat, n, sizeof(*pp.lat), cmp_u64);
+    r.segundos = (t1 - t0) / 1e9;
+    r.p50 = pp.lat[n / 2];
+    r.p99 = pp.lat[(long)(n * 0.99)];
+    r.p999 = pp.lat[(long)(n * 0.999)];
+    print_result(&r);
+out:
+    free(pp.lat);
+    return ret;
+}
+
+// ---- N productores / M consumidores ----
+
+struct throughput {
+    const struct transport *t;
+    struct chan ch;
+    size_t size;
+    long per_producer;
+    int productores;
+    pthread_barrier_t start;
+    long recibidos;
+    int err;
+};
+
+struct worker {
+    struct throughput *tp;
+    int idx;
+    long count;
+};
+
+static void *producer(void *arg) {
+    struct worker *w = arg;
+    struct throughput *tp = w->tp;
+    char *buf = calloc(1, tp->size);
+
+    pin_thread(w->idx);
+    pthread_barrier_wait(&tp->start);
+    for (long i = 0; i < w->count; i++) {
+        uint32_t id = (uint32_t)i;
+        int ret;
+
+        memcpy(buf, &id, sizeof(id));
+        ret = tp->t->send(&tp->ch, buf, tp->size);
+        if (ret) {
+            __atomic_store_n(&tp->err, -ret, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+    free(buf);
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    struct worker *w = arg;
+    struct throughput *tp = w->tp;
+    char *buf = calloc(1, tp->size);
+    uint32_t id;
+    int ret;
+
+    pin_thread(tp->productores + w->idx);
+    pthread_barrier_wait(&tp->start);
+    for (;;) {
+        ret = tp->t->recv(&tp->ch, buf, tp->size);
+        if (ret) {
+            __atomic_store_n(&tp->err, -ret, __ATOMIC_RELAXED);
+            break;
+        }
+        memcpy(&id, buf, sizeof(id));
+        if (id == SENTINEL)
+            break;
+        w->count++;
+    }
+    __atomic_fetch_add(&tp->recibidos, w->count, __ATOMIC_RELAXED);
+    free(buf);
+    return NULL;
+}
+
+static int run_throughput(const struct transport *t, size_t size, unsigned depth, long n,
+                          int productores, int consumidores) {
+    struct throughput tp = { .t = t, .size = size, .productores = productores };
+    struct result r = { "throughput", t->name, size, productores, consumidores, n, 0, 0, 0, 0 };
+    struct worker prod[MAX_THREADS], cons[MAX_THREADS];
+    pthread_t pt[MAX_THREADS], ct[MAX_THREADS];
+    char *stop;
+    uint64_t t0;
+    int ret;
+
+    // Varios escritores en un pipe solo son atómicos hasta PIPE_BUF
+    if (t->open == pipe_open && (productores > 1 || consumidores > 1) && size > PIPE_BUF)
+        return -EMSGSIZE;
+
+    ret = t->open(&tp.ch, size, depth);
+    if (ret)
+        return ret;
+
+    pthread_barrier_init(&tp.start, NULL, productores + consumidores + 1);
+    for (int i = 0; i < consumidores; i++) {
+        cons[i] = (struct worker){ &tp, i, 0 };
+        pthread_create(&ct[i], NULL, consumer, &cons[i]);
+    }
+    for (int i = 0; i < productores; i++) {
+        prod[i] = (struct worker){ &tp, i, n / productores + (i < n % productores) };
+        pthread_create(&pt[i], NULL, producer, &prod[i]);
+    }
+
+    pthread_barrier_wait(&tp.start);
+    t0 = now_ns();
+    for (int i = 0; i < productores; i++)
+        pthread_join(pt[i], NULL);
+
+    // Un mensaje de fin por consumidor, detrás de todos los mensajes de datos
+    stop = calloc(1, size);
+    memset(stop, 0xff, sizeof(uint32_t));
+    for (int i = 0; i < consumidores; i++)
+        t->send(&tp.ch, stop, size);
+    for (int i = 0; i < consumidores; i++)
+        pthread_join(ct[i], NULL);
+    r.segundos = (now_ns() - t0) / 1e9;
+    free(stop);
+
+    t->close(&tp.ch);
+    pthread_barrier_destroy(&tp.start);
+
+    if (tp.err)
+        return -tp.err;
+    r.mensajes = tp.recibidos;
+    print_result(&r);
+    return 0;
+}
+
+static void report_skip(const char *modo, const struct transport *t, size_t size, int err) {
+    fprintf(stderr, "Omitido: %s sobre %s con %zu bytes (%s)\n", modo, t->name, size, strerror(-err));
+}
+
+static void parse_cpus(char *list) {
+    for (char *tok = strtok(list, ","); tok && ncpus < MAX_CPUS; tok = strtok(NULL, ","))
+        cpus[ncpus++] = atoi(tok);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Error: %s [-m pingpong|throughput|sweep] [-t ipc|ipc-shm|pipe|mq|futex|all]\n"
+            "          [-n mensajes] [-s tamaño] [-d profundidad] [-p productores]\n"
+            "          [-c consumidores] [-a cpu,cpu,...] [-f csv|json]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    static const size_t sweep_sizes[] = { 8, 64, 256, 1024, 4096, 16384, 65536 };
+    const char *modo = "pingpong", *transporte = "all";
+    size_t size = 64;
+    unsigned depth = 256;
+    long n = 100000;
+    int productores = 1, consumidores = 1;
+    int opt, ret;
+
+    while ((opt = getopt(argc, argv, "m:t:n:s:d:p:c:a:f:")) != -1) {
+        switch (opt) {
+        case 'm': modo = optarg; break;
+        case 't': transporte = optarg; break;
+        case 'n': n = atol(optarg); break;
+        case 's': size = strtoul(optarg, NULL, 10); break;
+        case 'd': depth = strtoul(optarg, NULL, 10); break;
+        case 'p': productores = atoi(optarg); break;
+        case 'c': consumidores = atoi(optarg); break;
+        case 'a': parse_cpus(optarg); break;
+        case 'f': json = strcmp(optarg, "json") == 0; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (n < 1 || size < MIN_SIZE || depth < 1 || productores < 1 || consumidores < 1 ||
+        productores > MAX_THREADS || consumidores > MAX_THREADS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (json)
+        printf("[\n");
+
+    for (size_t i = 0; i < sizeof(transports) / sizeof(transports[0]); i++) {
+        const struct transport *t = &transports[i];
+
+        if (strcmp(transporte, "all") && strcmp(transporte, t->name))
+            continue;
+
+        if (!strcmp(modo, "pingpong")) {
+            ret = run_pingpong(t, size, depth, n);
+            if (ret)
+                report_skip(modo, t, size, ret);
+        } else if (!strcmp(modo, "throughput")) {
+            ret = run_throughput(t, size, depth, n, productores, consumidores);
+            if (ret)
+                report_skip(modo, t, size, ret);
+        } else if (!strcmp(modo, "sweep")) {
+            for (size_t j = 0; j < sizeof(sweep_sizes) / sizeof(sweep_sizes[0]); j++) {
+                ret = run_pingpong(t, sweep_sizes[j], depth, n);
+                if (ret)
+                    report_skip("pingpong", t, sweep_sizes[j], ret);
+                ret = run_throughput(t, sweep_sizes[j], depth, n, productores, consumidores);
+                if (ret)
+                    report_skip("throughput", t, sweep_sizes[j], ret);
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (json)
+        printf("%s]\n", filas ? "\n" : "");
+    return 0;
+}
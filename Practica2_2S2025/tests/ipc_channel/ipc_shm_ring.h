@@ -0,0 +1,202 @@
+// Anillo compartido de ipc_channel (canales creados con IPC_CHANNEL_SHM).
+// Los mensajes se escriben y leen directamente en las páginas mapeadas;
+// solo se entra al kernel (ipc_channel_futex) para dormir o despertar.
+#ifndef IPC_SHM_RING_H
+#define IPC_SHM_RING_H
+
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#define SYS_IPC_CHANNEL_FUTEX 476
+
+#define IPC_CHANNEL_SHM 0x1
+#define IPC_SHM_MAGIC 0x49504353
+
+#define IPC_FUTEX_WAIT_DATA 0
+#define IPC_FUTEX_WAIT_SPACE 1
+#define IPC_FUTEX_WAKE_DATA 2
+#define IPC_FUTEX_WAKE_SPACE 3
+
+struct ipc_shm_header {
+    uint32_t magic;
+    uint32_t depth;
+    uint32_t max_msg;
+    uint32_t slot_size;
+    uint32_t slots_offset;
+    uint32_t closed;
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    uint32_t data_seq __attribute__((aligned(64)));
+    uint32_t data_waiters;
+    uint32_t space_seq __attribute__((aligned(64)));
+    uint32_t space_waiters;
+};
+
+struct ipc_shm_slot {
+    uint64_t seq;
+    uint32_t len;
+    uint32_t reserved;
+    char dat[];
+};
+
+struct ipc_shm_ring {
+    int fd;
+    struct ipc_shm_header *h;
+    size_t size;
+};
+
+static inline struct ipc_shm_slot *shm_slot(struct ipc_shm_header *h, uint64_t pos) {
+    return (struct ipc_shm_slot *)((char *)h + h->slots_offset + (pos & (h->depth - 1)) * h->slot_size);
+}
+
+// Mapea el canal a partir del fd devuelto por ipc_channel_create/ipc_channel_open
+static inline int shm_ring_map(struct ipc_shm_ring *r, int fd) {
+    struct ipc_shm_header *h;
+    size_t size;
+
+    h = mmap(NULL, sizeof(*h), PROT_READ, MAP_SHARED, fd, 0);
+    if (h == MAP_FAILED)
+        return -errno;
+    if (h->magic != IPC_SHM_MAGIC) {
+        munmap(h, sizeof(*h));
+        return -EINVAL;
+    }
+    size = h->slots_offset + (size_t)h->depth * h->slot_size;
+    munmap(h, sizeof(*h));
+
+    h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (h == MAP_FAILED)
+        return -errno;
+
+    r->fd = fd;
+    r->h = h;
+    r->size = size;
+    return 0;
+}
+
+static inline void shm_ring_unmap(struct ipc_shm_ring *r) {
+    munmap(r->h, r->size);
+}
+
+static inline int shm_ring_try_push(struct ipc_shm_ring *r, const void *buf, uint32_t len) {
+    struct ipc_shm_header *h = r->h;
+    uint64_t pos = __atomic_load_n(&h->head, __ATOMIC_RELAXED);
+    struct ipc_shm_slot *s;
+
+    if (__atomic_load_n(&h->closed, __ATOMIC_RELAXED))
+        return -EPIPE;
+    if (len > h->max_msg)
+        len = h->max_msg;
+
+    for (;;) {
+        s = shm_slot(h, pos);
+        int64_t dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&h->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (dif < 0) {
+            return -EAGAIN;
+        } else {
+            pos = __atomic_load_n(&h->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(s->dat, buf, len);
+    s->len = len;
+    __atomic_store_n(&s->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // Solo se entra al kernel si hay consumidores dormidos
+    __atomic_fetch_add(&h->data_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&h->data_waiters, __ATOMIC_SEQ_CST))
+        syscall(SYS_IPC_CHANNEL_FUTEX, r->fd, IPC_FUTEX_WAKE_DATA, 0);
+    return len;
+}
+
+static inline int shm_ring_try_pop(struct ipc_shm_ring *r, void *buf, uint32_t len) {
+    struct ipc_shm_header *h = r->h;
+    uint64_t pos = __atomic_load_n(&h->tail, __ATOMIC_RELAXED);
+    struct ipc_shm_slot *s;
+
+    for (;;) {
+        s = shm_slot(h, pos);
+        int64_t dif = (int64_t)(__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&h->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (dif < 0) {
+            // Vacío: 0 si además está cerrado (fin del canal)
+            return __atomic_load_n(&h->closed, __ATOMIC_RELAXED) ? 0 : -EAGAIN;
+        } else {
+            pos = __atomic_load_n(&h->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    if (len > s->len)
+        len = s->len;
+    memcpy(buf, s->dat, len);
+    __atomic_store_n(&s->seq, pos + h->depth, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&h->space_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&h->space_waiters, __ATOMIC_SEQ_CST))
+        syscall(SYS_IPC_CHANNEL_FUTEX, r->fd, IPC_FUTEX_WAKE_SPACE, 0);
+    return len;
+}
+
+// Comprobaciones para repetir tras anunciarse como durmiente: un productor o
+// consumidor que publicó antes de ver el contador no llamará al kernel
+static inline int shm_ring_full(struct ipc_shm_header *h) {
+    uint64_t pos = __atomic_load_n(&h->head, __ATOMIC_SEQ_CST);
+
+    return (int64_t)(__atomic_load_n(&shm_slot(h, pos)->seq, __ATOMIC_SEQ_CST) - pos) < 0;
+}
+
+static inline int shm_ring_empty(struct ipc_shm_header *h) {
+    uint64_t pos = __atomic_load_n(&h->tail, __ATOMIC_SEQ_CST);
+
+    return (int64_t)(__atomic_load_n(&shm_slot(h, pos)->seq, __ATOMIC_SEQ_CST) - (pos + 1)) < 0;
+}
+
+// Envía un mensaje; duerme en el kernel solo si el anillo está lleno
+static inline int shm_ring_push(struct ipc_shm_ring *r, const void *buf, uint32_t len) {
+    struct ipc_shm_header *h = r->h;
+    uint32_t seq;
+    int ret;
+
+    while ((ret = shm_ring_try_push(r, buf, len)) == -EAGAIN) {
+        seq = __atomic_load_n(&h->space_seq, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&h->space_waiters, 1, __ATOMIC_SEQ_CST);
+        if (shm_ring_full(h) &&
+            syscall(SYS_IPC_CHANNEL_FUTEX, r->fd, IPC_FUTEX_WAIT_SPACE, seq) < 0 && errno != EINTR) {
+            __atomic_fetch_sub(&h->space_waiters, 1, __ATOMIC_SEQ_CST);
+            return -errno;
+        }
+        __atomic_fetch_sub(&h->space_waiters, 1, __ATOMIC_SEQ_CST);
+    }
+    return ret;
+}
+
+// Recibe un mensaje; duerme en el kernel solo si el anillo está vacío
+static inline int shm_ring_pop(struct ipc_shm_ring *r, void *buf, uint32_t len) {
+    struct ipc_shm_header *h = r->h;
+    uint32_t seq;
+    int ret;
+
+    while ((ret = shm_ring_try_pop(r, buf, len)) == -EAGAIN) {
+        seq = __atomic_load_n(&h->data_seq, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&h->data_waiters, 1, __ATOMIC_SEQ_CST);
+        if (shm_ring_empty(h) &&
+            syscall(SYS_IPC_CHANNEL_FUTEX, r->fd, IPC_FUTEX_WAIT_DATA, seq) < 0 && errno != EINTR) {
+            __atomic_fetch_sub(&h->data_waiters, 1, __ATOMIC_SEQ_CST);
+            return -errno;
+        }
+        __atomic_fetch_sub(&h->data_waiters, 1, __ATOMIC_SEQ_CST);
+    }
+    return ret;
+}
+
+#endif
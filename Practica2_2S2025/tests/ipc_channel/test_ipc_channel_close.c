@@ -0,0 +1,34 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <errno.h>
+
+#define SYS_IPC_CHANNEL_OPEN 474
+#define SYS_IPC_CHANNEL_CLOSE 475
+
+int main(int argc, char **argv) {
+    long fd;
+
+    if (argc != 2) {
+        fprintf(stderr, "Error: %s <canal>\n", argv[0]);
+        return 1;
+    }
+
+    fd = syscall(SYS_IPC_CHANNEL_OPEN, argv[1], 0);
+    if (fd < 0) {
+        perror("sys_ipc_channel_open fallo");
+        return 1;
+    }
+
+    if (syscall(SYS_IPC_CHANNEL_CLOSE, fd) < 0) {
+        perror("sys_ipc_channel_close fallo");
+        close(fd);
+        return 1;
+    }
+
+    printf("Canal \"%s\" cerrado exitosamente.\n", argv[1]);
+    close(fd);
+
+    return 0;
+}
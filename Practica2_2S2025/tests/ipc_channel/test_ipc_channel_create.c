@@ -0,0 +1,52 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define SYS_IPC_CHANNEL_CREATE 473
+#define IPC_CHANNEL_HANDOFF 0x2
+#define IPC_CHANNEL_BROADCAST 0x4
+#define IPC_CHANNEL_LAG 0x8
+
+int main(int argc, char **argv) {
+    unsigned int depth, max_msg;
+    int flags = 0;
+    long fd;
+
+    // Opciones: -h entrega directa, -b difusión, -l difusión que sobrescribe
+    while (argc > 4 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-h") == 0)
+            flags |= IPC_CHANNEL_HANDOFF;
+        else if (strcmp(argv[1], "-b") == 0)
+            flags |= IPC_CHANNEL_BROADCAST;
+        else if (strcmp(argv[1], "-l") == 0)
+            flags |= IPC_CHANNEL_BROADCAST | IPC_CHANNEL_LAG;
+        else
+            break;
+        argv++;
+        argc--;
+    }
+
+    if (argc != 4) {
+        fprintf(stderr, "Error: %s [-h|-b|-l] <canal> <profundidad> <tam_max_mensaje>\n", argv[0]);
+        return 1;
+    }
+
+    depth = (unsigned int)strtoul(argv[2], NULL, 10);
+    max_msg = (unsigned int)strtoul(argv[3], NULL, 10);
+
+    fd = syscall(SYS_IPC_CHANNEL_CREATE, argv[1], depth, max_msg, flags);
+    if (fd < 0) {
+        perror("sys_ipc_channel_create fallo");
+        return 1;
+    }
+
+    // El canal sigue registrado al cerrar el fd, hasta que se use ipc_channel_close
+    printf("Canal \"%s\" creado | Profundidad: %u | Tamaño máximo: %u bytes\n", argv[1], depth, max_msg);
+    close(fd);
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#define SYS_IPC_CHANNEL_RECVV 472
+#define SYS_IPC_CHANNEL_OPEN 474
+#define MAX_CHANNELS 64
+#define MAX_VEC_COUNT 16
+#define MAX_MSG_SIZE 512
+
+struct ipc_msg_vec {
+    uint64_t data_pointer;
+    uint32_t len;
+    uint32_t prio;
+};
+
+// Atiende varios canales desde un solo hilo con epoll
+int main(int argc, char **argv) {
+    static char buffers[MAX_VEC_COUNT][MAX_MSG_SIZE + 1];
+    struct ipc_msg_vec vec[MAX_VEC_COUNT];
+    struct epoll_event ev, events[MAX_CHANNELS];
+    int fds[MAX_CHANNELS];
+    int count = argc - 1;
+    int abiertos;
+    int epfd;
+
+    if (count < 1 || count > MAX_CHANNELS) {
+        fprintf(stderr, "Error: %s <canal1> [canal2 ... canalN]\n", argv[0]);
+        return 1;
+    }
+
+    epfd = epoll_create1(0);
+    if (epfd < 0) {
+        perror("epoll_create1 fallo");
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        fds[i] = syscall(SYS_IPC_CHANNEL_OPEN, argv[i + 1], O_NONBLOCK);
+        if (fds[i] < 0) {
+            perror("sys_ipc_channel_open fallo");
+            return 1;
+        }
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fds[i], &ev) < 0) {
+            perror("epoll_ctl fallo");
+            return 1;
+        }
+    }
+
+    abiertos = count;
+    while (abiertos > 0) {
+        int n = epoll_wait(epfd, events, MAX_CHANNELS, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait fallo");
+            return 1;
+        }
+
+        for (int e = 0; e < n; e++) {
+            int idx = events[e].data.u32;
+            long recibidos;
+
+            memset(vec, 0, sizeof(vec));
+            for (int i = 0; i < MAX_VEC_COUNT; i++) {
+                vec[i].data_pointer = (uintptr_t)buffers[i];
+                vec[i].len = MAX_MSG_SIZE;
+            }
+
+            // El fd es O_NONBLOCK: se toma lo que haya sin dormir
+            recibidos = syscall(SYS_IPC_CHANNEL_RECVV, fds[idx], vec, MAX_VEC_COUNT);
+            if (recibidos < 0) {
+                if (errno == EAGAIN)
+                    continue;
+                perror("sys_ipc_channel_recvv fallo");
+                return 1;
+            }
+            if (recibidos == 0) {
+                printf("[%s] Canal cerrado.\n", argv[idx + 1]);
+                epoll_ctl(epfd, EPOLL_CTL_DEL, fds[idx], NULL);
+                close(fds[idx]);
+                abiertos--;
+                continue;
+            }
+
+            for (long i = 0; i < recibidos; i++) {
+                buffers[i][vec[i].len] = '\0';
+                printf("[%s] Mensaje recibido: \"%s\" | Bytes recibidos: %u bytes\n",
+                       argv[idx + 1], buffers[i], vec[i].len);
+            }
+        }
+    }
+
+    close(epfd);
+    return 0;
+}
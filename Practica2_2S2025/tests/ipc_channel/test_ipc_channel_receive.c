@@ -2,26 +2,45 @@
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
 #define SYS_IPC_CHANNEL_RECEIVE 468
-#define MAX_MSG_SIZE 256
+#define MAX_MSG_SIZE 512
 
-int main(void) {
-    char data_msg[MAX_MSG_SIZE + 1];
+int main(int argc, char **argv) {
+    // Tamaño del buffer opcional, para recibir mensajes grandes
+    size_t size = (argc > 1) ? strtoul(argv[1], NULL, 10) : MAX_MSG_SIZE;
+    char *data_msg;
     long bytes_recibidos;
 
-    bytes_recibidos = syscall(SYS_IPC_CHANNEL_RECEIVE, data_msg, MAX_MSG_SIZE);
+    if (size == 0) {
+        fprintf(stderr, "Error: el tamaño del buffer debe ser mayor que 0.\n");
+        return 1;
+    }
+
+    data_msg = malloc(size + 1);
+    if (!data_msg) {
+        perror("malloc fallo");
+        return 1;
+    }
+
+    bytes_recibidos = syscall(SYS_IPC_CHANNEL_RECEIVE, data_msg, size);
     
     if (bytes_recibidos < 0) {
         perror("sys_ipc_channel_receive fallo");
+        free(data_msg);
         return 1;
     }
 
     data_msg[bytes_recibidos] = '\0';
     
-    printf("Mensaje recibido: \"%s\" | Bytes recibidos: %ld bytes\n", data_msg, bytes_recibidos);
+    if (bytes_recibidos <= MAX_MSG_SIZE)
+        printf("Mensaje recibido: \"%s\" | Bytes recibidos: %ld bytes\n", data_msg, bytes_recibidos);
+    else
+        printf("Mensaje grande recibido | Bytes recibidos: %ld bytes\n", bytes_recibidos);
 
+    free(data_msg);
     return 0;
-}
\ No newline at end of file
+}
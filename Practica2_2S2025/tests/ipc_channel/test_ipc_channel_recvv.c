@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+
+#define SYS_IPC_CHANNEL_RECVV 472
+#define SYS_IPC_CHANNEL_OPEN 474
+#define SYS_IPC_CHANNEL_TIMEDRECVV 478
+#define IPC_CHANNEL_DEFAULT -1
+#define MAX_VEC_COUNT 64
+#define MAX_MSG_SIZE 512
+
+struct ipc_msg_vec {
+    uint64_t data_pointer;
+    uint32_t len;
+    uint32_t prio;
+};
+
+int main(int argc, char **argv) {
+    static char buffers[MAX_VEC_COUNT][MAX_MSG_SIZE + 1];
+    struct ipc_msg_vec vec[MAX_VEC_COUNT];
+    int fd = IPC_CHANNEL_DEFAULT;
+    int first = 1;
+    int count;
+    int timeout = -1;
+    long recibidos;
+
+    // Canal con nombre opcional: -c <canal>
+    if (argc > first + 1 && strcmp(argv[first], "-c") == 0) {
+        fd = syscall(SYS_IPC_CHANNEL_OPEN, argv[first + 1], 0);
+        if (fd < 0) {
+            perror("sys_ipc_channel_open fallo");
+            return 1;
+        }
+        first += 2;
+    }
+
+    // Tiempo máximo de espera opcional en segundos: -t <segundos>
+    if (argc > first + 1 && strcmp(argv[first], "-t") == 0) {
+        timeout = atoi(argv[first + 1]);
+        first += 2;
+    }
+
+    count = (argc > first) ? atoi(argv[first]) : 16;
+    if (count < 1 || count > MAX_VEC_COUNT) {
+        fprintf(stderr, "Error: la cantidad debe estar entre 1 y %d\n", MAX_VEC_COUNT);
+        return 1;
+    }
+
+    memset(vec, 0, sizeof(vec));
+    for (int i = 0; i < count; i++) {
+        vec[i].data_pointer = (uintptr_t)buffers[i];
+        vec[i].len = MAX_MSG_SIZE;
+    }
+
+    if (timeout >= 0) {
+        // El límite es absoluto sobre CLOCK_MONOTONIC
+        struct timespec limite;
+        clock_gettime(CLOCK_MONOTONIC, &limite);
+        limite.tv_sec += timeout;
+        recibidos = syscall(SYS_IPC_CHANNEL_TIMEDRECVV, fd, vec, count, &limite);
+    } else {
+        recibidos = syscall(SYS_IPC_CHANNEL_RECVV, fd, vec, count);
+    }
+
+    if (recibidos < 0 && errno == ETIMEDOUT) {
+        printf("No llegaron mensajes en %d segundos.\n", timeout);
+        return 0;
+    }
+    if (recibidos < 0) {
+        perror("sys_ipc_channel_recvv fallo");
+        return 1;
+    }
+    if (recibidos == 0) {
+        printf("El canal fue cerrado y no quedan mensajes.\n");
+        return 0;
+    }
+
+    for (long i = 0; i < recibidos; i++) {
+        buffers[i][vec[i].len] = '\0';
+        printf("Mensaje %ld: \"%s\" | Bytes recibidos: %u bytes | Prioridad: %u\n",
+               i + 1, buffers[i], vec[i].len, vec[i].prio);
+    }
+
+    return 0;
+}
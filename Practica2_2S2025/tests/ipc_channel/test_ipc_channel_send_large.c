@@ -0,0 +1,56 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#define SYS_IPC_CHANNEL_SEND 467
+
+// Envía un mensaje de N bytes (mayor que 512 usa páginas fijadas) y mide cuánto tarda
+// en ser recibido. Ejecutar junto a: ./ipc_receive <N>
+int main(int argc, char **argv) {
+    struct timespec inicio, fin;
+    size_t size;
+    char *msg;
+    long bytes_enviados;
+    double segundos;
+
+    if (argc != 2) {
+        fprintf(stderr, "Error: %s <tamaño_en_bytes>\n", argv[0]);
+        return 1;
+    }
+
+    size = strtoul(argv[1], NULL, 10);
+    if (size == 0) {
+        fprintf(stderr, "Error: el tamaño debe ser mayor que 0.\n");
+        return 1;
+    }
+
+    msg = malloc(size);
+    if (!msg) {
+        perror("malloc fallo");
+        return 1;
+    }
+    for (size_t i = 0; i < size; i++)
+        msg[i] = 'a' + (i % 26);
+
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    bytes_enviados = syscall(SYS_IPC_CHANNEL_SEND, msg, size);
+    clock_gettime(CLOCK_MONOTONIC, &fin);
+
+    if (bytes_enviados < 0) {
+        perror("sys_ipc_channel_send fallo");
+        free(msg);
+        return 1;
+    }
+
+    segundos = (fin.tv_sec - inicio.tv_sec) + (fin.tv_nsec - inicio.tv_nsec) / 1e9;
+    printf("Bytes enviados: %ld bytes | Tiempo hasta la entrega: %.6f s | %.2f MB/s\n",
+           bytes_enviados, segundos, bytes_enviados / segundos / 1e6);
+
+    free(msg);
+    return 0;
+}
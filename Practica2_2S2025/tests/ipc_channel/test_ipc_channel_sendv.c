@@ -0,0 +1,72 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#define SYS_IPC_CHANNEL_SENDV 471
+#define SYS_IPC_CHANNEL_OPEN 474
+#define IPC_CHANNEL_DEFAULT -1
+#define MAX_VEC_COUNT 64
+#define IPC_PRIO_LEVELS 32
+
+struct ipc_msg_vec {
+    uint64_t data_pointer;
+    uint32_t len;
+    uint32_t prio;
+};
+
+int main(int argc, char **argv) {
+    struct ipc_msg_vec vec[MAX_VEC_COUNT];
+    int fd = IPC_CHANNEL_DEFAULT;
+    int first = 1;
+    int count;
+    int prio = 0;
+    long enviados;
+
+    // Canal con nombre opcional: -c <canal>
+    if (argc > first + 1 && strcmp(argv[first], "-c") == 0) {
+        fd = syscall(SYS_IPC_CHANNEL_OPEN, argv[first + 1], 0);
+        if (fd < 0) {
+            perror("sys_ipc_channel_open fallo");
+            return 1;
+        }
+        first += 2;
+    }
+
+    // Prioridad opcional de todo el lote: -p <prioridad>
+    if (argc > first + 1 && strcmp(argv[first], "-p") == 0) {
+        prio = atoi(argv[first + 1]);
+        first += 2;
+    }
+
+    count = argc - first;
+    if (count < 1 || prio < 0 || prio >= IPC_PRIO_LEVELS) {
+        fprintf(stderr, "Error: %s [-c canal] [-p prioridad 0-%d] <mensaje1> [mensaje2 ... mensajeN]\n",
+                argv[0], IPC_PRIO_LEVELS - 1);
+        return 1;
+    }
+    if (count > MAX_VEC_COUNT)
+        count = MAX_VEC_COUNT;
+
+    memset(vec, 0, sizeof(vec));
+    for (int i = 0; i < count; i++) {
+        vec[i].data_pointer = (uintptr_t)argv[first + i];
+        vec[i].len = strlen(argv[first + i]);
+        vec[i].prio = prio;
+    }
+
+    enviados = syscall(SYS_IPC_CHANNEL_SENDV, fd, vec, count);
+
+    if (enviados < 0) {
+        perror("sys_ipc_channel_sendv fallo");
+        return 1;
+    }
+
+    printf("Mensajes enviados en un solo lote: %ld de %d\n", enviados, count);
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#define SYS_IPC_CHANNEL_OPEN 474
+#define SYS_IPC_CHANNEL_SET_PRIO_DEPTH 479
+
+int main(int argc, char **argv) {
+    long fd;
+    unsigned int prio, depth;
+
+    if (argc != 4) {
+        fprintf(stderr, "Error: %s <canal> <prioridad> <profundidad>\n", argv[0]);
+        return 1;
+    }
+
+    prio = strtoul(argv[2], NULL, 10);
+    depth = strtoul(argv[3], NULL, 10);
+
+    fd = syscall(SYS_IPC_CHANNEL_OPEN, argv[1], 0);
+    if (fd < 0) {
+        perror("sys_ipc_channel_open fallo");
+        return 1;
+    }
+
+    if (syscall(SYS_IPC_CHANNEL_SET_PRIO_DEPTH, fd, prio, depth) < 0) {
+        perror("sys_ipc_channel_set_prio_depth fallo");
+        close(fd);
+        return 1;
+    }
+
+    printf("Nivel %u del canal \"%s\" creado con %u casillas.\n", prio, argv[1], depth);
+    close(fd);
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ipc_shm_ring.h"
+
+#define SYS_IPC_CHANNEL_CREATE 473
+#define SYS_IPC_CHANNEL_OPEN 474
+#define MAX_MSG_SIZE 512
+
+// Uso:
+//   test_ipc_channel_shm create <canal> <profundidad> <tam_max_mensaje>
+//   test_ipc_channel_shm send <canal> <mensaje1> [mensaje2 ... mensajeN]
+//   test_ipc_channel_shm recv <canal> <cantidad>
+int main(int argc, char **argv) {
+    struct ipc_shm_ring ring = {0};
+    char data_msg[MAX_MSG_SIZE + 1];
+    long fd;
+    int ret;
+
+    if (argc < 4) {
+        fprintf(stderr, "Error: %s create|send|recv <canal> ...\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "create") == 0) {
+        if (argc != 5) {
+            fprintf(stderr, "Error: %s create <canal> <profundidad> <tam_max_mensaje>\n", argv[0]);
+            return 1;
+        }
+        fd = syscall(SYS_IPC_CHANNEL_CREATE, argv[2], (unsigned int)atoi(argv[3]),
+                     (unsigned int)atoi(argv[4]), IPC_CHANNEL_SHM);
+        if (fd < 0) {
+            perror("sys_ipc_channel_create fallo");
+            return 1;
+        }
+        printf("Canal compartido \"%s\" creado.\n", argv[2]);
+        close(fd);
+        return 0;
+    }
+
+    fd = syscall(SYS_IPC_CHANNEL_OPEN, argv[2], 0);
+    if (fd < 0) {
+        perror("sys_ipc_channel_open fallo");
+        return 1;
+    }
+
+    ret = shm_ring_map(&ring, fd);
+    if (ret < 0) {
+        fprintf(stderr, "No se pudo mapear el canal: %s\n", strerror(-ret));
+        return 1;
+    }
+
+    if (strcmp(argv[1], "send") == 0) {
+        for (int i = 3; i < argc; i++) {
+            ret = shm_ring_push(&ring, argv[i], strlen(argv[i]));
+            if (ret < 0) {
+                fprintf(stderr, "Error al enviar: %s\n", strerror(-ret));
+                return 1;
+            }
+            printf("Mensaje enviado: \"%s\" | Bytes enviados: %d bytes\n", argv[i], ret);
+        }
+    } else if (strcmp(argv[1], "recv") == 0) {
+        int count = atoi(argv[3]);
+        for (int i = 0; i < count; i++) {
+            ret = shm_ring_pop(&ring, data_msg, MAX_MSG_SIZE);
+            if (ret < 0) {
+                fprintf(stderr, "Error al recibir: %s\n", strerror(-ret));
+                return 1;
+            }
+            if (ret == 0) {
+                printf("El canal fue cerrado y no quedan mensajes.\n");
+                break;
+            }
+            data_msg[ret] = '\0';
+            printf("Mensaje recibido: \"%s\" | Bytes recibidos: %d bytes\n", data_msg, ret);
+        }
+    } else {
+        fprintf(stderr, "Operación desconocida: %s\n", argv[1]);
+        return 1;
+    }
+
+    shm_ring_unmap(&ring);
+    close(fd);
+    return 0;
+}
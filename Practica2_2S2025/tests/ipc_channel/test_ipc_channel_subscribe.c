@@ -0,0 +1,69 @@
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#define SYS_IPC_CHANNEL_RECVV 472
+#define SYS_IPC_CHANNEL_OPEN 474
+#define IPC_CHANNEL_SUBSCRIBE 0x10
+#define MAX_VEC_COUNT 16
+#define MAX_MSG_SIZE 512
+
+struct ipc_msg_vec {
+    uint64_t data_pointer;
+    uint32_t len;
+    uint32_t prio;
+};
+
+// Se suscribe a un canal de difusión y muestra cada mensaje hasta que se
+// cierre el canal. Varios suscriptores reciben los mismos mensajes.
+int main(int argc, char **argv) {
+    static char buffers[MAX_VEC_COUNT][MAX_MSG_SIZE + 1];
+    struct ipc_msg_vec vec[MAX_VEC_COUNT];
+    long fd, recibidos, total = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "Error: %s <canal>\n", argv[0]);
+        return 1;
+    }
+
+    fd = syscall(SYS_IPC_CHANNEL_OPEN, argv[1], IPC_CHANNEL_SUBSCRIBE);
+    if (fd < 0) {
+        perror("sys_ipc_channel_open fallo");
+        return 1;
+    }
+
+    for (;;) {
+        for (int i = 0; i < MAX_VEC_COUNT; i++) {
+            vec[i].data_pointer = (uintptr_t)buffers[i];
+            vec[i].len = MAX_MSG_SIZE;
+            vec[i].prio = 0;
+        }
+
+        recibidos = syscall(SYS_IPC_CHANNEL_RECVV, fd, vec, MAX_VEC_COUNT);
+        if (recibidos < 0 && errno == EOVERFLOW) {
+            printf("Suscriptor atrasado: se perdieron mensajes, continuando con el más antiguo disponible.\n");
+            continue;
+        }
+        if (recibidos < 0) {
+            perror("sys_ipc_channel_recvv fallo");
+            close(fd);
+            return 1;
+        }
+        if (recibidos == 0)
+            break;
+
+        for (long i = 0; i < recibidos; i++) {
+            buffers[i][vec[i].len] = '\0';
+            printf("Mensaje %ld: \"%s\"\n", ++total, buffers[i]);
+        }
+    }
+
+    printf("El canal fue cerrado. Mensajes recibidos: %ld\n", total);
+    close(fd);
+    return 0;
+}
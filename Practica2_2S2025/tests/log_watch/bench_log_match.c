@@ -0,0 +1,592 @@
+// Compara el buscador de log_watch (Horspool con prefiltro de byte poco
+// común) contra la búsqueda ingenua anterior, sobre logs reales o sintéticos.
+// Con -m compara además Aho-Corasick con todas las palabras a la vez contra
+// buscar cada palabra por separado en cada línea.
+//
+// lw_compile/lw_find, ac_compile y find_byte son copia de kernel/log_watch.c; find_byte
+// usa el mismo truco de palabra de máquina que <asm/word-at-a-time.h>.
+// Ambos buscadores recorren el corpus línea por línea, como el kernel, y se
+// verifica que encuentren las mismas líneas.
+//
+// Uso:
+//   bench_log_match [-i] [-m] [-r repeticiones] [-s MB] [-k palabra ...] [archivo ...]
+//
+// Sin archivos se genera un corpus sintético de -s MB (por defecto 64) con
+// líneas tipo syslog. -k puede repetirse; sin -k se usa una lista fija.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOG_WATCH_MAX_KEYWORD 128
+#define MAX_KEYWORDS 32
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// ---- Copia de kernel/log_watch.c ----
+
+struct lw_matcher {
+    u8 pat[LOG_WATCH_MAX_KEYWORD];
+    u32 len;
+    u32 rare;
+    bool icase;
+    u8 skip[256];
+};
+
+#define ONES (~0ul / 0xff)
+#define HIGHS (ONES * 0x80)
+
+static const char *find_byte(const char *p, size_t len, u8 c) {
+    const char *end = p + len;
+    unsigned long w, z;
+
+    while ((size_t)(end - p) >= sizeof(unsigned long)) {
+        memcpy(&w, p, sizeof(w));
+        w ^= ONES * c;
+        z = (w - ONES) & ~w & HIGHS;
+        if (z)
+            return p + __builtin_ctzl(z) / 8;
+        p += sizeof(unsigned long);
+    }
+    return memchr(p, c, end - p);
+}
+
+static inline const char *find_eol(const char *p, size_t len) {
+    return find_byte(p, len, '\n');
+}
+
+static const char *find_any(const char *p, size_t len, const u8 *set, u32 n) {
+    const char *end = p + len;
+    unsigned long w, x;
+    u32 i;
+
+    while ((size_t)(end - p) >= sizeof(unsigned long)) {
+        memcpy(&w, p, sizeof(w));
+        for (i = 0; i < n; i++) {
+            x = w ^ (ONES * set[i]);
+            if ((x - ONES) & ~x & HIGHS)
+                goto bytes;
+        }
+        p += sizeof(unsigned long);
+    }
+bytes:
+    for (; p < end; p++) {
+        for (i = 0; i < n; i++) {
+            if ((u8)*p == set[i])
+                return p;
+        }
+    }
+    return NULL;
+}
+
+static u8 byte_rank(u8 c) {
+    if (c == ' ')
+        return 255;
+    if (c && strchr("etaoinsrhl", c))
+        return 200;
+    if (islower(c))
+        return 160;
+    if (isdigit(c))
+        return 150;
+    if (c && strchr(":.-/[]=,_()", c))
+        return 120;
+    if (isupper(c))
+        return 60;
+    return 20;
+}
+
+static void lw_compile(struct lw_matcher *m, const char *kw, size_t len, bool icase) {
+    u32 i, best = 256;
+
+    m->len = len;
+    m->icase = icase;
+    m->rare = len;
+    for (i = 0; i < len; i++)
+        m->pat[i] = icase ? tolower((u8)kw[i]) : kw[i];
+
+    for (i = 0; i < 256; i++)
+        m->skip[i] = len;
+    for (i = 0; i + 1 < len; i++) {
+        m->skip[m->pat[i]] = len - 1 - i;
+        if (icase)
+            m->skip[toupper(m->pat[i])] = len - 1 - i;
+    }
+
+    for (i = 0; i < len; i++) {
+        if (icase && isalpha(m->pat[i]))
+            continue;
+        if (byte_rank(m->pat[i]) < best) {
+            best = byte_rank(m->pat[i]);
+            m->rare = i;
+        }
+    }
+    if (best > 150)
+        m->rare = len;
+}
+
+static inline bool lw_equal(const struct lw_matcher *m, const char *s) {
+    u32 i;
+
+    if (!m->icase)
+        return !memcmp(s, m->pat, m->len);
+    for (i = 0; i < m->len; i++) {
+        if (tolower((u8)s[i]) != m->pat[i])
+            return false;
+    }
+    return true;
+}
+
+static const char *lw_horspool(const struct lw_matcher *m, const char *s, size_t n) {
+    const char *p = s, *last;
+    u8 c, tail = m->pat[m->len - 1];
+
+    if (n < m->len)
+        return NULL;
+    for (last = s + n - m->len; p <= last; p += m->skip[c]) {
+        c = p[m->len - 1];
+        if ((m->icase ? tolower(c) : c) == tail && lw_equal(m, p))
+            return p;
+    }
+    return NULL;
+}
+
+static const char *lw_find(const struct lw_matcher *m, const char *s, size_t n) {
+    const char *p = s, *hit;
+    size_t fails = 0;
+
+    if (!m->len)
+        return s;
+    if (n < m->len)
+        return NULL;
+    if (m->rare == m->len)
+        return lw_horspool(m, s, n);
+
+    while (p + m->len <= s + n) {
+        hit = find_byte(p + m->rare, s + n - m->len + 1 - p, m->pat[m->rare]);
+        if (!hit)
+            return NULL;
+        p = hit - m->rare;
+        if (lw_equal(m, p))
+            return p;
+        p++;
+        if (++fails > 8 && (size_t)(p - s) < fails * 16)
+            return lw_horspool(m, p, s + n - p);
+    }
+    return NULL;
+}
+
+// Aho-Corasick (ac_compile es copia literal; estas macros lo adaptan)
+#define GFP_KERNEL 0
+#define kzalloc(n, f) calloc(1, n)
+#define kvmalloc_array(n, s, f) malloc((n) * (s))
+#define kvfree free
+#define kfree free
+#define U16_MAX UINT16_MAX
+#define U32_MAX UINT32_MAX
+#define min(a, b) ((a) < (b) ? (a) : (b))
+typedef uint16_t u16;
+
+// Autómata de Aho-Corasick para varias palabras clave, como DFA completo.
+// Los bytes se agrupan en clases (cada byte usado en alguna palabra tiene la
+// suya, el resto comparte la clase 0 y '\n' tiene una que vuelve a la raíz),
+// así cada estado ocupa ncls entradas y la tabla suele caber en caché.
+// Cada entrada es (fila del estado destino << 1) | (el destino termina una
+// palabra), de modo que avanzar un byte es una sola lectura de la tabla.
+// Si las palabras empiezan con a lo más AC_MAX_START bytes distintos, desde
+// la raíz se salta directo al siguiente de esos bytes.
+#define AC_MAX_START 3
+
+struct lw_ac {
+    u16 cls[256];
+    u32 ncls;
+    u32 nstates;
+    u8 start[AC_MAX_START];
+    u32 nstart;                     // 0 = sin prefiltro
+    u32 *trans;                     // nstates * ncls entradas
+    u16 *out;                       // Palabra que termina en cada estado
+};
+
+#define AC_NONE U32_MAX
+
+// Construye el autómata de Aho-Corasick para las palabras kw (ninguna vacía).
+// Primero arma el trie con AC_NONE en las transiciones que faltan y luego,
+// en orden BFS, las completa con las del estado de falla.
+static struct lw_ac *ac_compile(const char **kw, u32 nkw, bool icase) {
+    struct lw_ac *ac;
+    u32 *fail = NULL, *queue = NULL;
+    u32 i, j, c, s, next, max_states = 1, head = 0, tail = 0;
+    const u8 *w;
+    u8 b;
+
+    ac = kzalloc(sizeof(*ac), GFP_KERNEL);
+    if (!ac)
+        return NULL;
+
+    // Clases de bytes: 0 = no aparece en ninguna palabra, 1 = '\n'
+    ac->ncls = 2;
+    ac->cls['\n'] = 1;
+    for (i = 0; i < nkw; i++) {
+        for (w = (const u8 *)kw[i]; *w; w++) {
+            b = icase ? tolower(*w) : *w;
+            if (!ac->cls[b]) {
+                ac->cls[b] = ac->ncls++;
+                if (icase)
+                    ac->cls[toupper(b)] = ac->cls[b];
+            }
+            max_states++;
+        }
+    }
+
+    ac->trans = kvmalloc_array((size_t)max_states * ac->ncls, sizeof(u32), GFP_KERNEL);
+    ac->out = kvmalloc_array(max_states, sizeof(u16), GFP_KERNEL);
+    fail = kvmalloc_array(max_states, sizeof(u32), GFP_KERNEL);
+    queue = kvmalloc_array(max_states, sizeof(u32), GFP_KERNEL);
+    if (!ac->trans || !ac->out || !fail || !queue)
+        goto err;
+    memset(ac->trans, 0xff, (size_t)max_states * ac->ncls * sizeof(u32));
+    memset(ac->out, 0xff, max_states * sizeof(u16));
+
+    // Bytes con los que empiezan las palabras, para el prefiltro
+    for (i = 0; i < nkw && ac->nstart <= AC_MAX_START; i++) {
+        b = icase ? tolower(kw[i][0]) : kw[i][0];
+        for (j = 0; j < 2; j++, b = toupper(b)) {
+            if (memchr(ac->start, b, min(ac->nstart, AC_MAX_START)))
+                continue;
+            if (ac->nstart < AC_MAX_START)
+                ac->start[ac->nstart] = b;
+            ac->nstart++;
+            if (!icase)
+                break;
+        }
+    }
+    if (ac->nstart > AC_MAX_START)
+        ac->nstart = 0;
+
+    // Trie. Si una palabra se repite se queda la primera.
+    ac->nstates = 1;
+    for (i = 0; i < nkw; i++) {
+        s = 0;
+        for (w = (const u8 *)kw[i]; *w; w++) {
+            c = ac->cls[icase ? tolower(*w) : *w];
+            if (ac->trans[s * ac->ncls + c] == AC_NONE)
+                ac->trans[s * ac->ncls + c] = ac->nstates++;
+            s = ac->trans[s * ac->ncls + c];
+        }
+        if (ac->out[s] == U16_MAX)
+            ac->out[s] = i;
+    }
+
+    // Transiciones de la raíz: lo que no está en el trie vuelve a la raíz
+    for (c = 0; c < ac->ncls; c++) {
+        next = ac->trans[c];
+        if (next == AC_NONE) {
+            ac->trans[c] = 0;
+        } else {
+            fail[next] = 0;
+            queue[tail++] = next;
+        }
+    }
+
+    while (head < tail) {
+        s = queue[head++];
+        for (c = 0; c < ac->ncls; c++) {
+            next = ac->trans[s * ac->ncls + c];
+            if (next == AC_NONE) {
+                ac->trans[s * ac->ncls + c] = ac->trans[fail[s] * ac->ncls + c];
+                continue;
+            }
+            fail[next] = ac->trans[fail[s] * ac->ncls + c];
+            // Un estado también termina las palabras de su estado de falla
+            if (ac->out[next] == U16_MAX)
+                ac->out[next] = ac->out[fail[next]];
+            queue[tail++] = next;
+        }
+    }
+
+    // Codificar las entradas como fila del destino más la marca de palabra
+    for (j = 0; j < ac->nstates * ac->ncls; j++) {
+        next = ac->trans[j];
+        ac->trans[j] = (next * ac->ncls) << 1 | (ac->out[next] != U16_MAX);
+    }
+
+    kvfree(fail);
+    kvfree(queue);
+    return ac;
+
+err:
+    kvfree(fail);
+    kvfree(queue);
+    kvfree(ac->trans);
+    kvfree(ac->out);
+    kfree(ac);
+    return NULL;
+}
+
+static void ac_free(struct lw_ac *ac) {
+    if (!ac)
+        return;
+    kvfree(ac->trans);
+    kvfree(ac->out);
+    kfree(ac);
+}
+
+// Como ac_scan, pero cuenta las líneas con alguna palabra
+static size_t ac_count(const struct lw_ac *ac, const char *buf, size_t len) {
+    const char *eol, *start;
+    uint32_t row = 0, e;
+    size_t i, hits = 0;
+
+    for (i = 0; i < len; i++) {
+        if (!row && ac->nstart) {
+            start = find_any(buf + i, len - i, ac->start, ac->nstart);
+            if (!start)
+                break;
+            i = start - buf;
+        }
+        e = ac->trans[row + ac->cls[(u8)buf[i]]];
+        row = e >> 1;
+        if (!(e & 1))
+            continue;
+        hits++;
+        eol = find_eol(buf + i, len - i);
+        if (!eol)
+            eol = buf + len;
+        i = eol - buf;
+        row = 0;
+    }
+    return hits;
+}
+
+// ---- Rutina anterior (contains_keyword) ----
+
+static int contains_keyword(const char *line, size_t len, const char *keyword, size_t kwlen, bool icase) {
+    if (len < kwlen) return 0;
+    for (size_t i = 0; i <= len - kwlen; i++) {
+        if (!(icase ? strncasecmp(line + i, keyword, kwlen) : memcmp(line + i, keyword, kwlen)))
+            return 1;
+    }
+    return 0;
+}
+
+// ---- Corpus ----
+
+static char *gen_corpus(size_t size) {
+    static const char *hosts[] = { "web01", "web02", "db-primary", "cache3", "worker17" };
+    static const char *svcs[] = { "nginx", "sshd", "postgres", "kernel", "systemd", "app" };
+    static const char *msgs[] = {
+        "GET /api/v1/users/%u HTTP/1.1 200 %u bytes in %u ms",
+        "Accepted publickey for deploy from 10.0.%u.%u port %u ssh2",
+        "checkpoint complete: wrote %u buffers (%u.%u%%)",
+        "Connection reset by peer while reading response header from upstream %u",
+        "ERROR: duplicate key value violates unique constraint \"users_pkey\" id=%u %u %u",
+        "worker %u: request timeout after %u ms, retrying (%u)",
+        "Out of memory: Killed process %u (java) total-vm:%ukB, anon-rss:%ukB",
+        "Started Session %u of user root. uid=%u gid=%u",
+        "warning: cache miss ratio %u.%u above threshold %u",
+    };
+    static const unsigned weights[] = { 40, 10, 8, 3, 2, 3, 1, 20, 13 };
+    char *buf = malloc(size + 512);
+    size_t off = 0;
+    unsigned seed = 12345, t = 0;
+
+    if (!buf)
+        return NULL;
+    while (off < size) {
+        unsigned r, w = 0, i;
+
+        seed = seed * 1103515245 + 12345;
+        r = (seed >> 8) % 100;
+        for (i = 0; i < 8 && r >= w + weights[i]; i++)
+            w += weights[i];
+        t += seed % 7;
+        off += sprintf(buf + off, "Sep %2u %02u:%02u:%02u %s %s[%u]: ", 1 + t / 86400 % 30,
+                       t / 3600 % 24, t / 60 % 60, t % 60, hosts[seed % 5], svcs[(seed >> 4) % 6],
+                       1000 + seed % 30000);
+        off += sprintf(buf + off, msgs[i], seed % 9973, (seed >> 3) % 977, (seed >> 7) % 251);
+        buf[off++] = '\n';
+    }
+    return buf;
+}
+
+static char *load_files(char **files, int n, size_t *size) {
+    char *buf = NULL;
+    size_t off = 0;
+
+    for (int i = 0; i < n; i++) {
+        FILE *f = fopen(files[i], "rb");
+        long len;
+
+        if (!f) {
+            perror(files[i]);
+            exit(1);
+        }
+        fseek(f, 0, SEEK_END);
+        len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        buf = realloc(buf, off + len + 1);
+        if (!buf || fread(buf + off, 1, len, f) != (size_t)len) {
+            fprintf(stderr, "Error al leer %s\n", files[i]);
+            exit(1);
+        }
+        off += len;
+        fclose(f);
+    }
+    *size = off;
+    return buf;
+}
+
+// Recorre el corpus línea por línea; modo 0 = ingenuo, 1 = lw_find
+static size_t scan(const char *buf, size_t size, int mode, const struct lw_matcher *m,
+                   const char *kw, size_t kwlen, bool icase) {
+    const char *p = buf, *end = buf + size, *eol;
+    size_t hits = 0;
+
+    while (p < end) {
+        eol = find_eol(p, end - p);
+        if (!eol)
+            eol = end;
+        if (mode ? lw_find(m, p, eol - p) != NULL : contains_keyword(p, eol - p, kw, kwlen, icase))
+            hits++;
+        p = eol + 1;
+    }
+    return hits;
+}
+
+// Todas las palabras a la vez: Aho-Corasick contra lw_find por palabra
+static int bench_multi(const char *buf, size_t size, const char **kws, int nkw, bool icase, int reps) {
+    struct lw_matcher m[MAX_KEYWORDS];
+    struct lw_ac *ac = ac_compile(kws, nkw, icase);
+    uint64_t best[2] = { UINT64_MAX, UINT64_MAX };
+    size_t hits[2] = { 0, 0 };
+
+    if (!ac)
+        return 1;
+    for (int k = 0; k < nkw; k++)
+        lw_compile(&m[k], kws[k], strlen(kws[k]), icase);
+
+    for (int r = 0; r < reps; r++) {
+        uint64_t t0 = now_ns();
+        const char *p = buf, *end = buf + size, *eol;
+
+        hits[0] = 0;
+        while (p < end) {
+            eol = find_eol(p, end - p);
+            if (!eol)
+                eol = end;
+            for (int k = 0; k < nkw; k++) {
+                if (lw_find(&m[k], p, eol - p)) {
+                    hits[0]++;
+                    break;
+                }
+            }
+            p = eol + 1;
+        }
+        t0 = now_ns() - t0;
+        if (t0 < best[0])
+            best[0] = t0;
+
+        t0 = now_ns();
+        hits[1] = ac_count(ac, buf, size);
+        t0 = now_ns() - t0;
+        if (t0 < best[1])
+            best[1] = t0;
+    }
+
+    printf("\n%d palabras a la vez (%u estados, %u clases de bytes, %zu KiB de tabla)\n", nkw,
+           ac->nstates, ac->ncls, (size_t)ac->nstates * ac->ncls * sizeof(u32) / 1024);
+    printf("%-28s %10s %12s\n", "buscador", "líneas", "MB/s");
+    printf("%-28s %10zu %12.1f\n", "lw_find por palabra", hits[0], size / 1048576.0 / (best[0] / 1e9));
+    printf("%-28s %10zu %12.1f\n", "Aho-Corasick", hits[1], size / 1048576.0 / (best[1] / 1e9));
+    ac_free(ac);
+    if (hits[0] != hits[1]) {
+        fprintf(stderr, "DIFERENCIA: lw_find %zu, Aho-Corasick %zu\n", hits[0], hits[1]);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static const char *default_kw[] = { "ERROR", "timeout", "Out of memory", "Connection reset by peer",
+                                         "users_pkey", "[4242]", "e", "zzzz-not-present" };
+    const char *kws[MAX_KEYWORDS];
+    int nkw = 0, reps = 5, opt, bad = 0;
+    double mb = 64;
+    bool icase = false, multi = false;
+    char *buf;
+    size_t size;
+
+    while ((opt = getopt(argc, argv, "imr:s:k:")) != -1) {
+        switch (opt) {
+        case 'i': icase = true; break;
+        case 'm': multi = true; break;
+        case 'r': reps = atoi(optarg); break;
+        case 's': mb = atof(optarg); break;
+        case 'k':
+            if (nkw < MAX_KEYWORDS && strlen(optarg) < LOG_WATCH_MAX_KEYWORD)
+                kws[nkw++] = optarg;
+            break;
+        default:
+            fprintf(stderr, "Uso: %s [-i] [-m] [-r repeticiones] [-s MB] [-k palabra ...] [archivo ...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!nkw) {
+        for (size_t i = 0; i < sizeof(default_kw) / sizeof(default_kw[0]); i++)
+            kws[nkw++] = default_kw[i];
+    }
+
+    if (optind < argc)
+        buf = load_files(&argv[optind], argc - optind, &size);
+    else {
+        size = (size_t)(mb * 1024 * 1024);
+        buf = gen_corpus(size);
+    }
+    if (!buf)
+        return 1;
+
+    printf("corpus: %.1f MB%s\n", size / 1048576.0, icase ? ", sin distinguir mayúsculas" : "");
+    printf("%-28s %10s %12s %12s %8s\n", "palabra", "líneas", "ingenuo MB/s", "lw_find MB/s", "mejora");
+
+    for (int k = 0; k < nkw; k++) {
+        struct lw_matcher m;
+        size_t kwlen = strlen(kws[k]), hits[2] = { 0, 0 };
+        uint64_t best[2] = { UINT64_MAX, UINT64_MAX };
+
+        lw_compile(&m, kws[k], kwlen, icase);
+        for (int r = 0; r < reps; r++) {
+            for (int mode = 0; mode < 2; mode++) {
+                uint64_t t0 = now_ns();
+
+                hits[mode] = scan(buf, size, mode, &m, kws[k], kwlen, icase);
+                t0 = now_ns() - t0;
+                if (t0 < best[mode])
+                    best[mode] = t0;
+            }
+        }
+        if (hits[0] != hits[1]) {
+            fprintf(stderr, "DIFERENCIA en '%s': ingenuo %zu, lw_find %zu\n", kws[k], hits[0], hits[1]);
+            bad = 1;
+        }
+        printf("%-28s %10zu %12.1f %12.1f %7.2fx\n", kws[k], hits[1],
+               size / 1048576.0 / (best[0] / 1e9), size / 1048576.0 / (best[1] / 1e9),
+               (double)best[0] / best[1]);
+    }
+
+    if (multi)
+        bad |= bench_multi(buf, size, kws, nkw, icase, reps);
+
+    free(buf);
+    return bad;
+}
@@ -0,0 +1,192 @@
+// Mide cuántos MB/s lee log_watch de un archivo que crece continuamente.
+//
+// El programa escribe líneas sin la palabra clave en un log monitoreado, a la
+// velocidad indicada (o lo más rápido posible), y al final agrega una línea
+// marcadora que sí la contiene. Se mide el tiempo desde la primera escritura
+// hasta que la marcadora aparece en el log central, y el retraso entre que
+// el escritor termina y la marcadora llega.
+//
+// Uso:
+//   bench_log_watch [-s MB] [-r MB/s] [-l bytes_por_línea] [-m N] [-w segundos] <directorio>
+//
+// -r 0 (por defecto) escribe sin límite de velocidad.
+// -m N hace que una de cada N líneas de relleno contenga la palabra clave, para
+// medir una ráfaga de coincidencias. La marcadora lleva además un sufijo que
+// el relleno no tiene.
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <limits.h>
+
+#define SYS_START_LOG_WATCH 469
+#define SYS_STOP_LOG_WATCH  470
+
+#define CHUNK (64 * 1024)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// ¿Ya contiene el log central la palabra marcadora? Lee solo lo nuevo
+// desde la llamada anterior.
+static int central_has(const char *path, const char *keyword) {
+    static char buf[CHUNK + 64];
+    static off_t off;
+    static size_t keep;
+    size_t kwlen = strlen(keyword);
+    ssize_t n;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return 0;
+    while ((n = pread(fd, buf + keep, CHUNK, off)) > 0) {
+        size_t len = keep + n;
+
+        off += n;
+        if (memmem(buf, len, keyword, kwlen)) {
+            close(fd);
+            return 1;
+        }
+        // Conservar el final por si la palabra quedó partida entre lecturas
+        keep = (len < kwlen - 1) ? len : kwlen - 1;
+        memmove(buf, buf + len - keep, keep);
+    }
+    close(fd);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [-s MB] [-r MB/s] [-l bytes_por_línea] [-m N] [-w segundos] <directorio>\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    double total_mb = 256, rate_mb = 0;
+    size_t line_len = 120, every = 0;
+    int wait_s = 60;
+    char log_path[PATH_MAX], central_path[PATH_MAX], keyword[64], marker[80];
+    const char *paths[2];
+    static char chunk[CHUNK];
+    uint64_t total, written = 0, t0, t_end, t_match, deadline;
+    long id;
+    int opt, fd, ifd;
+
+    while ((opt = getopt(argc, argv, "s:r:l:m:w:")) != -1) {
+        switch (opt) {
+        case 's': total_mb = atof(optarg); break;
+        case 'r': rate_mb = atof(optarg); break;
+        case 'l': line_len = strtoul(optarg, NULL, 10); break;
+        case 'm': every = strtoul(optarg, NULL, 10); break;
+        case 'w': wait_s = atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || line_len < 2 || line_len > CHUNK || total_mb <= 0)
+        usage(argv[0]);
+
+    snprintf(log_path, sizeof(log_path), "%s/bench_log_watch.log", argv[optind]);
+    snprintf(central_path, sizeof(central_path), "%s/bench_log_watch_central.log", argv[optind]);
+    snprintf(keyword, sizeof(keyword), "LWBENCH_%d", getpid());
+    snprintf(marker, sizeof(marker), "%s_FIN", keyword);
+    if (every && line_len < strlen(keyword) + 2)
+        usage(argv[0]);
+
+    fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        perror("Error al crear el log");
+        return 1;
+    }
+    unlink(central_path);
+
+    paths[0] = log_path;
+    paths[1] = NULL;
+    id = syscall(SYS_START_LOG_WATCH, paths, central_path, keyword);
+    if (id == -1) {
+        perror("Error al iniciar monitoreo");
+        return 1;
+    }
+
+    // Bloque de líneas de relleno sin la palabra clave
+    for (size_t i = 0; i < CHUNK; i++)
+        chunk[i] = ((i + 1) % line_len == 0) ? '\n' : "abcdefghijklmnopqrstuvwxyz0123456789 "[i % 37];
+    // Con -m, una de cada N líneas completas del bloque empieza con la palabra
+    if (every) {
+        for (size_t l = 0; (l + 1) * line_len <= CHUNK; l += every)
+            memcpy(chunk + l * line_len, keyword, strlen(keyword));
+    }
+
+    ifd = inotify_init1(IN_NONBLOCK);
+    total = (uint64_t)(total_mb * 1024 * 1024);
+
+    t0 = now_ns();
+    while (written < total) {
+        size_t n = (total - written < CHUNK) ? total - written : CHUNK;
+
+        if (write(fd, chunk, n) != (ssize_t)n) {
+            perror("Error al escribir el log");
+            break;
+        }
+        written += n;
+        // Limitar la velocidad de escritura
+        if (rate_mb > 0) {
+            uint64_t due = t0 + (uint64_t)(written / (rate_mb * 1024 * 1024) * 1e9);
+            uint64_t t = now_ns();
+            if (due > t) {
+                struct timespec ts = { (time_t)((due - t) / 1000000000ull), (long)((due - t) % 1000000000ull) };
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+    dprintf(fd, "\n%s\n", marker);
+    t_end = now_ns();
+
+    // Esperar a que la marcadora llegue al log central
+    if (ifd >= 0)
+        inotify_add_watch(ifd, central_path, IN_MODIFY);
+    deadline = t_end + (uint64_t)wait_s * 1000000000ull;
+    t_match = 0;
+    while (now_ns() < deadline) {
+        struct pollfd p = { .fd = ifd, .events = POLLIN };
+        char ev[4096];
+
+        if (central_has(central_path, marker)) {
+            t_match = now_ns();
+            break;
+        }
+        poll(ifd >= 0 ? &p : NULL, ifd >= 0 ? 1 : 0, 10);
+        while (ifd >= 0 && read(ifd, ev, sizeof(ev)) > 0)
+            ;
+    }
+
+    syscall(SYS_STOP_LOG_WATCH, (uint32_t)id);
+    close(fd);
+
+    printf("escrito:    %.1f MB en %.3f s (%.1f MB/s)\n", written / 1048576.0,
+           (t_end - t0) / 1e9, written / 1048576.0 / ((t_end - t0) / 1e9));
+    if (!t_match) {
+        printf("la marcadora no llegó al log central en %d s: log_watch no alcanzó al escritor\n", wait_s);
+        return 1;
+    }
+    printf("leído:      %.1f MB en %.3f s (%.1f MB/s)\n", written / 1048576.0,
+           (t_match - t0) / 1e9, written / 1048576.0 / ((t_match - t0) / 1e9));
+    printf("retraso:    %.3f ms tras la última escritura\n", (t_match - t_end) / 1e6);
+    if (every) {
+        struct stat st;
+
+        if (!stat(central_path, &st))
+            printf("central:    %.1f MB de coincidencias\n", st.st_size / 1048576.0);
+    }
+    return 0;
+}
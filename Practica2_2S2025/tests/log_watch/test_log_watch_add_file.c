@@ -0,0 +1,31 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <stdint.h>
+
+#define SYS_LOG_WATCH_ADD_FILE 481
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Error, se espera: %s <ID_MONITOREO> <log1> [log2 ... logN]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t id = (uint32_t)strtoul(argv[1], NULL, 10);
+    int ret = 0;
+
+    for (int i = 2; i < argc; i++) {
+        long idx = syscall(SYS_LOG_WATCH_ADD_FILE, id, argv[i]);
+
+        if (idx == -1) {
+            fprintf(stderr, "%s: ", argv[i]);
+            perror("Error al agregar el archivo");
+            ret = 1;
+            continue;
+        }
+        printf("%s agregado al monitoreo %u (índice %ld)\n", argv[i], id, idx);
+    }
+    return ret;
+}
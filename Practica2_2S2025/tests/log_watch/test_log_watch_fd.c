@@ -0,0 +1,115 @@
+// Recibe las coincidencias de log_watch por un fd, sin log central.
+//
+// Uso:
+//   test_log_watch_fd <palabra_clave> <log1> [log2 ... logN]
+//
+// Inicia el monitoreo con LOG_WATCH_FD, abre su anillo con log_watch_open y
+// muestra cada registro con el texto de la línea, que se lee del archivo con
+// offset y len. Con Ctrl+C detiene el monitoreo y vacía lo que quedaba.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <stdint.h>
+
+#define SYS_START_LOG_WATCH_EX 480
+#define SYS_STOP_LOG_WATCH     470
+#define SYS_LOG_WATCH_OPEN     484
+
+#define LOG_WATCH_FD 0x2
+
+struct log_watch_rec {
+    uint64_t offset;
+    uint64_t time_ns;
+    uint32_t len;
+    uint32_t file;
+    uint32_t keyword;
+    uint32_t reserved;
+};
+
+static volatile sig_atomic_t stop;
+
+static void on_sigint(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static void print_rec(const struct log_watch_rec *r, char **paths, int npaths, int *fds) {
+    char line[256], when[32];
+    time_t t = r->time_ns / 1000000000ull;
+    size_t n = r->len < sizeof(line) ? r->len : sizeof(line) - 1;
+    ssize_t got = -1;
+
+    strftime(when, sizeof(when), "%H:%M:%S", localtime(&t));
+    if ((int)r->file < npaths)
+        got = pread(fds[r->file], line, n, r->offset);
+    line[got > 0 ? got : 0] = '\0';
+    printf("%s %s:%llu palabra %u: %s\n", when, (int)r->file < npaths ? paths[r->file] : "?",
+           (unsigned long long)r->offset, r->keyword, line);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Error, se espera: %s <palabra_clave> <log1> [log2 ... logN]\n", argv[0]);
+        return 1;
+    }
+
+    char **paths = &argv[2];
+    int npaths = argc - 2, total = 0;
+    int *fds = calloc(npaths, sizeof(int));
+    struct log_watch_rec recs[64];
+    long id;
+    int fd;
+
+    for (int i = 0; i < npaths; i++)
+        fds[i] = open(paths[i], O_RDONLY);
+
+    // Lista terminada en NULL: argv ya lo está
+    id = syscall(SYS_START_LOG_WATCH_EX, paths, NULL, argv[1], LOG_WATCH_FD);
+    if (id == -1) {
+        perror("Error al iniciar monitoreo");
+        return 1;
+    }
+    fd = syscall(SYS_LOG_WATCH_OPEN, (uint32_t)id, O_CLOEXEC);
+    if (fd == -1) {
+        perror("Error al abrir el anillo");
+        syscall(SYS_STOP_LOG_WATCH, (uint32_t)id);
+        return 1;
+    }
+    printf("ID Monitoreo = %ld, esperando coincidencias (Ctrl+C para terminar)\n", id);
+
+    signal(SIGINT, on_sigint);
+    while (!stop) {
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+
+        if (poll(&p, 1, 500) <= 0)
+            continue;
+        ssize_t n = read(fd, recs, sizeof(recs));
+        for (ssize_t i = 0; i < n / (ssize_t)sizeof(recs[0]); i++, total++)
+            print_rec(&recs[i], paths, npaths, fds);
+    }
+
+    // Después de detenerlo, read entrega lo que quedó y luego 0
+    syscall(SYS_STOP_LOG_WATCH, (uint32_t)id);
+    for (;;) {
+        ssize_t n = read(fd, recs, sizeof(recs));
+
+        if (n <= 0)
+            break;
+        for (ssize_t i = 0; i < n / (ssize_t)sizeof(recs[0]); i++, total++)
+            print_rec(&recs[i], paths, npaths, fds);
+    }
+    printf("%d coincidencias recibidas\n", total);
+
+    close(fd);
+    for (int i = 0; i < npaths; i++)
+        close(fds[i]);
+    free(fds);
+    return 0;
+}
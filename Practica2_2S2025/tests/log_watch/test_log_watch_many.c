@@ -0,0 +1,130 @@
+// Inicia N monitoreos sobre el mismo log y muestra cuántos hilos del kernel
+// y cuánta memoria del kernel (Slab + KernelStack de /proc/meminfo) cuestan.
+// Después escribe una línea con la palabra clave, espera a que llegue a los
+// N logs centrales y detiene todos los monitoreos.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <limits.h>
+
+#define SYS_START_LOG_WATCH 469
+#define SYS_STOP_LOG_WATCH  470
+
+// Suma en KiB de los campos indicados de /proc/meminfo
+static long meminfo_kb(void) {
+    FILE *f = fopen("/proc/meminfo", "r");
+    char line[256];
+    long v, total = 0;
+
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "Slab: %ld kB", &v) == 1 || sscanf(line, "KernelStack: %ld kB", &v) == 1)
+            total += v;
+    }
+    fclose(f);
+    return total;
+}
+
+// Hilos del kernel cuyo nombre empieza con "log_watch"
+static int count_threads(void) {
+    DIR *d = opendir("/proc");
+    struct dirent *e;
+    char path[300], comm[64];
+    int n = 0;
+
+    if (!d)
+        return -1;
+    while ((e = readdir(d))) {
+        FILE *f;
+
+        if (e->d_name[0] < '0' || e->d_name[0] > '9')
+            continue;
+        snprintf(path, sizeof(path), "/proc/%s/comm", e->d_name);
+        f = fopen(path, "r");
+        if (!f)
+            continue;
+        if (fgets(comm, sizeof(comm), f) && !strncmp(comm, "log_watch", 9))
+            n++;
+        fclose(f);
+    }
+    closedir(d);
+    return n;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Error, se espera: %s <directorio> <cantidad>\n", argv[0]);
+        return 1;
+    }
+
+    const char *dir = argv[1];
+    int n = atoi(argv[2]), started = 0, found = 0;
+    char log_path[PATH_MAX], central[PATH_MAX];
+    long *ids = calloc(n, sizeof(long));
+    const char *paths[2] = { log_path, NULL };
+    long mem0, mem1;
+    int thr0, thr1;
+
+    if (n <= 0 || !ids) {
+        fprintf(stderr, "Cantidad inválida\n");
+        return 1;
+    }
+
+    snprintf(log_path, sizeof(log_path), "%s/many.log", dir);
+    close(open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+
+    sync();
+    mem0 = meminfo_kb();
+    thr0 = count_threads();
+
+    for (int i = 0; i < n; i++) {
+        snprintf(central, sizeof(central), "%s/many_central_%d.log", dir, i);
+        unlink(central);
+        ids[i] = syscall(SYS_START_LOG_WATCH, paths, central, "MANY_FIN");
+        if (ids[i] == -1) {
+            perror("Error al iniciar monitoreo");
+            break;
+        }
+        started++;
+    }
+
+    mem1 = meminfo_kb();
+    thr1 = count_threads();
+    printf("monitoreos:          %d\n", started);
+    printf("hilos log_watch*:    %d (antes %d)\n", thr1, thr0);
+    printf("Slab+KernelStack:    %+ld KiB (%.1f KiB por monitoreo)\n", mem1 - mem0,
+           started ? (double)(mem1 - mem0) / started : 0.0);
+
+    // Una escritura debe llegar a todos los logs centrales
+    int fd = open(log_path, O_WRONLY | O_APPEND);
+    dprintf(fd, "linea con MANY_FIN\n");
+    close(fd);
+    for (int t = 0; t < 50 && found < started; t++) {
+        usleep(100000);
+        found = 0;
+        for (int i = 0; i < started; i++) {
+            struct stat st;
+
+            snprintf(central, sizeof(central), "%s/many_central_%d.log", dir, i);
+            if (!stat(central, &st) && st.st_size > 0)
+                found++;
+        }
+    }
+    printf("logs centrales con la línea: %d de %d\n", found, started);
+
+    for (int i = 0; i < started; i++) {
+        if (syscall(SYS_STOP_LOG_WATCH, (uint32_t)ids[i]) == -1)
+            perror("Error al detener el monitoreo");
+    }
+
+    free(ids);
+    return found == started ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Varios monitoreos sobre el mismo archivo: dos lo reciben al iniciar y un
+// tercero lo agrega con log_watch_add_file. Una escritura con la palabra
+// clave debe llegar a los tres logs centrales.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <limits.h>
+
+#define SYS_START_LOG_WATCH    469
+#define SYS_STOP_LOG_WATCH     470
+#define SYS_LOG_WATCH_ADD_FILE 481
+
+#define N 3
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Error, se espera: %s <directorio>\n", argv[0]);
+        return 1;
+    }
+
+    const char *dir = argv[1];
+    char log_path[PATH_MAX], other[PATH_MAX], central[N][PATH_MAX];
+    const char *paths[2] = { log_path, NULL };
+    const char *other_paths[2] = { other, NULL };
+    long ids[N];
+    int started = 0, found = 0, ret = 1;
+
+    snprintf(log_path, sizeof(log_path), "%s/shared.log", dir);
+    snprintf(other, sizeof(other), "%s/shared_other.log", dir);
+    close(open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    close(open(other, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+
+    for (int i = 0; i < N; i++) {
+        snprintf(central[i], sizeof(central[i]), "%s/shared_central_%d.log", dir, i);
+        unlink(central[i]);
+        // Los dos primeros empiezan con el log compartido; el último con otro
+        ids[i] = syscall(SYS_START_LOG_WATCH, i < N - 1 ? paths : other_paths, central[i], "SHARED_FIN");
+        if (ids[i] == -1) {
+            perror("Error al iniciar monitoreo");
+            goto out;
+        }
+        started++;
+    }
+
+    long idx = syscall(SYS_LOG_WATCH_ADD_FILE, (uint32_t)ids[N - 1], log_path);
+    if (idx == -1) {
+        perror("Error al agregar el log compartido");
+        goto out;
+    }
+
+    int fd = open(log_path, O_WRONLY | O_APPEND);
+    dprintf(fd, "linea con SHARED_FIN\n");
+    close(fd);
+    for (int t = 0; t < 50 && found < N; t++) {
+        usleep(100000);
+        found = 0;
+        for (int i = 0; i < N; i++) {
+            struct stat st;
+
+            if (!stat(central[i], &st) && st.st_size > 0)
+                found++;
+        }
+    }
+    printf("logs centrales con la línea: %d de %d\n", found, N);
+    ret = found == N ? 0 : 1;
+
+out:
+    for (int i = 0; i < started; i++) {
+        if (syscall(SYS_STOP_LOG_WATCH, (uint32_t)ids[i]) == -1)
+            perror("Error al detener el monitoreo");
+    }
+    return ret;
+}
@@ -1,23 +1,48 @@
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <stdint.h>
 
 #define SYS_START_LOG_WATCH 469
+#define SYS_START_LOG_WATCH_EX 480
+#define SYS_START_LOG_WATCH_CURSOR 485
+
+#define LOG_WATCH_ICASE 0x1
 
 int main(int argc, char **argv) {
-    if (argc < 4) {
-        fprintf(stderr, "Error, se espera: %s <log_central> <palabra_clave> <log1> [log2 ... logN]\n", argv[0]);
+    unsigned int flags = 0;
+    const char *cursor = NULL;
+    int opt;
+
+    // -i: sin distinguir mayúsculas (usa start_log_watch_ex)
+    // -c cursor: continuar desde las posiciones guardadas en cursor
+    while ((opt = getopt(argc, argv, "+ic:")) != -1) {
+        switch (opt) {
+        case 'i': flags |= LOG_WATCH_ICASE; break;
+        case 'c': cursor = optarg; break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind < 3) {
+        fprintf(stderr, "Error, se espera: %s [-i] [-c cursor] <log_central> <palabra_clave> <log1> [log2 ... logN]\n", argv[0]);
         return 1;
     }
 
-    const char *central_log = argv[1];
-    const char *keyword = argv[2];
-    const char *const *log_paths = (const char *const *)&argv[3];
+    const char *central_log = argv[optind];
+    const char *keyword = argv[optind + 1];
+    const char *const *log_paths = (const char *const *)&argv[optind + 2];
 
-    long id = syscall(SYS_START_LOG_WATCH, log_paths, central_log, keyword);
+    long id;
+    if (cursor)
+        id = syscall(SYS_START_LOG_WATCH_CURSOR, log_paths, central_log, keyword, flags, cursor);
+    else if (flags)
+        id = syscall(SYS_START_LOG_WATCH_EX, log_paths, central_log, keyword, flags);
+    else
+        id = syscall(SYS_START_LOG_WATCH, log_paths, central_log, keyword);
     if (id == -1) {
         perror("Error al iniciar monitoreo");
         return 1;